@@ -26,8 +26,12 @@
 #include "cocaine/repository.hpp"
 #include "cocaine/traits.hpp"
 
+#include <list>
 #include <mutex>
 #include <sstream>
+#include <typeinfo>
+
+#include <boost/optional.hpp>
 
 namespace cocaine {
 
@@ -42,6 +46,188 @@ struct storage_error_t:
 
 namespace api {
 
+// Read-only view of a stored object, which keeps the underlying memory alive as long as any view of
+// it exists. Backends might either map the object into memory or hand over an owned buffer.
+
+class blob_t {
+public:
+    blob_t():
+        m_data(nullptr),
+        m_size(0)
+    { }
+
+    explicit
+    blob_t(std::string&& buffer) {
+        auto owner = std::make_shared<std::string>(std::move(buffer));
+
+        m_data  = owner->data();
+        m_size  = owner->size();
+        m_owner = owner;
+    }
+
+    blob_t(const char* data, size_t size, const std::shared_ptr<const void>& owner):
+        m_data(data),
+        m_size(size),
+        m_owner(owner)
+    { }
+
+    const char*
+    data() const {
+        return m_data;
+    }
+
+    size_t
+    size() const {
+        return m_size;
+    }
+
+    blob_t
+    slice(size_t offset, size_t size) const {
+        return blob_t(m_data + offset, size, m_owner);
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+
+    std::shared_ptr<const void> m_owner;
+};
+
+// Object cache
+
+class object_cache_t {
+    COCAINE_DECLARE_NONCOPYABLE(object_cache_t)
+
+    typedef std::pair<std::string, std::string> key_type;
+    typedef std::list<key_type> lru_list_t;
+
+    struct entry_t {
+        // Opaque object version as reported by the storage backend.
+        std::string version;
+
+        // Already unpacked object, type-erased. The type info is checked on every lookup, so that
+        // the same object might be requested as different types without ambiguity.
+        std::shared_ptr<void> object;
+        const std::type_info* type;
+
+        // Object footprint, which is approximated by its serialized size.
+        size_t size;
+
+        lru_list_t::iterator position;
+    };
+
+    typedef std::map<key_type, entry_t> entry_map_t;
+
+public:
+    explicit
+    object_cache_t(size_t limit):
+        m_limit(limit),
+        m_size(0)
+    { }
+
+    template<class T>
+    std::shared_ptr<const T>
+    get(const std::string& collection, const std::string& key, const std::string& version);
+
+    template<class T>
+    void
+    insert(const std::string& collection, const std::string& key, const std::string& version, const T& object,
+           size_t size);
+
+    void
+    invalidate(const std::string& collection, const std::string& key) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        auto it = m_entries.find(key_type(collection, key));
+
+        if(it != m_entries.end()) {
+            erase(it);
+        }
+    }
+
+private:
+    void
+    erase(entry_map_t::iterator it) {
+        m_size -= it->second.size;
+        m_lru.erase(it->second.position);
+        m_entries.erase(it);
+    }
+
+private:
+    // Maximum total footprint of the cached objects, in bytes. Zero disables the cache.
+    const size_t m_limit;
+
+    size_t m_size;
+
+    // The most recently used objects are at the front of the list.
+    lru_list_t  m_lru;
+    entry_map_t m_entries;
+
+    std::mutex m_mutex;
+};
+
+template<class T>
+std::shared_ptr<const T>
+object_cache_t::get(const std::string& collection, const std::string& key, const std::string& version) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto it = m_entries.find(key_type(collection, key));
+
+    if(it == m_entries.end()) {
+        return std::shared_ptr<const T>();
+    }
+
+    if(it->second.version != version) {
+        // The object has been modified bypassing this cache, e.g. by another process.
+        erase(it);
+        return std::shared_ptr<const T>();
+    }
+
+    if(*it->second.type != typeid(T)) {
+        return std::shared_ptr<const T>();
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second.position);
+
+    return std::static_pointer_cast<const T>(it->second.object);
+}
+
+template<class T>
+void
+object_cache_t::insert(const std::string& collection, const std::string& key, const std::string& version,
+                       const T& object, size_t size)
+{
+    if(size > m_limit) {
+        return;
+    }
+
+    auto ptr = std::make_shared<T>(object);
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    auto it = m_entries.find(key_type(collection, key));
+
+    if(it != m_entries.end()) {
+        erase(it);
+    }
+
+    while(m_size + size > m_limit) {
+        erase(m_entries.find(m_lru.back()));
+    }
+
+    entry_t& entry = m_entries[key_type(collection, key)];
+
+    entry.version  = version;
+    entry.object   = ptr;
+    entry.type     = &typeid(T);
+    entry.size     = size;
+    entry.position = m_lru.insert(m_lru.begin(), key_type(collection, key));
+
+    m_size += size;
+}
+
+// Storage interface
+
 struct storage_t {
     typedef storage_t category_type;
 
@@ -66,6 +252,22 @@ struct storage_t {
     std::vector<std::string>
     find(const std::string& collection, const std::vector<std::string>& tags) = 0;
 
+    // Same as read(), but might avoid copying the object, which matters for huge objects like app
+    // archives. The default implementation simply takes ownership of the read() result.
+    virtual
+    blob_t
+    view(const std::string& collection, const std::string& key) {
+        return blob_t(read(collection, key));
+    }
+
+    // Returns an opaque token which changes every time the object is modified, or nothing if the
+    // backend is unable to tell. Only the objects with a known version are cached by get<T>().
+    virtual
+    boost::optional<std::string>
+    version(const std::string& /* collection */, const std::string& /* key */) {
+        return boost::none;
+    }
+
     // Helper methods
 
     template<class T>
@@ -76,18 +278,49 @@ struct storage_t {
     void
     put(const std::string& collection, const std::string& key, const T& object, const std::vector<std::string>& tags);
 
+    // Same as get<std::string>(), but the result refers to the stored object directly, bypassing
+    // the object cache.
+    blob_t
+    get_view(const std::string& collection, const std::string& key);
+
+    // NOTE: Storage instances come and go, so the object cache is owned by the storage factory
+    // and shared between all the instances with the same name.
+    void
+    attach(const std::shared_ptr<object_cache_t>& cache) {
+        m_cache = cache;
+    }
+
 protected:
     storage_t(context_t&, const std::string& /* name */, const dynamic_t& /* args */) {
         // Empty.
     }
+
+    // Backends must call this on every modification of an object which might have been cached.
+    void
+    invalidate(const std::string& collection, const std::string& key) {
+        if(m_cache) m_cache->invalidate(collection, key);
+    }
+
+private:
+    std::shared_ptr<object_cache_t> m_cache;
 };
 
 template<class T>
 T
 storage_t::get(const std::string& collection, const std::string& key) {
+    boost::optional<std::string> current;
+
+    if(m_cache && (current = version(collection, key))) {
+        if(auto object = m_cache->get<T>(collection, key, *current)) {
+            return *object;
+        }
+    }
+
     T result;
     msgpack::unpacked unpacked;
 
+    // NOTE: The version is fetched before the object, so if the object is modified in between,
+    // the stale version will be cached along with the new object and simply miss next time.
     std::string blob(read(collection, key));
 
     try {
@@ -102,9 +335,44 @@ storage_t::get(const std::string& collection, const std::string& key) {
         throw storage_error_t("object type mismatch");
     }
 
+    if(current) {
+        m_cache->insert(collection, key, *current, result, blob.size());
+    }
+
     return result;
 }
 
+inline
+blob_t
+storage_t::get_view(const std::string& collection, const std::string& key) {
+    msgpack::unpacked unpacked;
+
+    blob_t blob(view(collection, key));
+
+    try {
+        msgpack::unpack(&unpacked, blob.data(), blob.size());
+    } catch(const msgpack::unpack_error& e) {
+        throw storage_error_t("corrupted object");
+    }
+
+    const msgpack::object& object = unpacked.get();
+
+    if(object.type != msgpack::type::RAW) {
+        throw storage_error_t("object type mismatch");
+    }
+
+    const char* payload = object.via.raw.ptr;
+    const size_t size = object.via.raw.size;
+
+    // NOTE: Unpacked raw objects point straight into the source buffer, so the payload can be sliced
+    // out of the blob without copying it. The check is for unpackers which might copy it instead.
+    if(payload < blob.data() || payload + size > blob.data() + blob.size()) {
+        return blob_t(std::string(payload, size));
+    }
+
+    return blob.slice(payload - blob.data(), size);
+}
+
 template<class T>
 void
 storage_t::put(const std::string& collection, const std::string& key, const T& object, const std::vector<std::string>& tags) {
@@ -148,6 +416,21 @@ struct category_traits<storage_t> {
                     args
                 );
 
+                typename cache_map_t::iterator cache(m_caches.find(name));
+
+                if(cache == m_caches.end()) {
+                    const size_t limit = args.as_object().at("cache-size", 64 * 1024 * 1024).to<size_t>();
+
+                    cache = m_caches.insert(cache, std::make_pair(
+                        name,
+                        limit ? std::make_shared<object_cache_t>(limit) : nullptr
+                    ));
+                }
+
+                if(cache->second) {
+                    instance->attach(cache->second);
+                }
+
                 m_instances[name] = instance;
             }
 
@@ -161,6 +444,14 @@ struct category_traits<storage_t> {
         > instance_map_t;
 
         instance_map_t m_instances;
+
+        typedef std::map<
+            std::string,
+            std::shared_ptr<object_cache_t>
+        > cache_map_t;
+
+        cache_map_t m_caches;
+
         std::mutex m_mutex;
     };
 };
@@ -59,7 +59,8 @@ struct reactor_t {
     reactor_t():
         m_loop(new ev::dynamic_loop()),
         m_loop_queue_pump(new ev::prepare(*m_loop)),
-        m_loop_async_wake(new ev::async(*m_loop))
+        m_loop_async_wake(new ev::async(*m_loop)),
+        m_lifetime(std::make_shared<int>(0))
     {
         // Pumps queued jobs on beginning of each loop iteration.
         m_loop_queue_pump->set<reactor_t, &reactor_t::process>(this);
@@ -127,6 +128,13 @@ public:
         return *m_loop;
     }
 
+    // Expires along with the reactor. Unlike the reactor address, which might be reused by another
+    // reactor later on, it can be used to key the state shared by the users of this reactor.
+    std::weak_ptr<void>
+    lifetime() const {
+        return m_lifetime;
+    }
+
 private:
     void
     process(ev::prepare&, int) {
@@ -172,6 +180,8 @@ private:
 
     std::deque<job_type> m_job_queue;
     std::mutex m_job_queue_mutex;
+
+    std::shared_ptr<void> m_lifetime;
 };
 
 }} // namespace cocaine::io
@@ -126,6 +126,33 @@ struct socket {
         return length;
     }
 
+    // Operations for unconnected sockets
+
+    ssize_t
+    write(const char* buffer, size_t size, const endpoint_type& endpoint, std::error_code& ec) {
+        ssize_t length = ::sendto(m_fd, buffer, size, 0, endpoint.data(), endpoint.size());
+
+        if(length == -1 && (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            ec = std::error_code(errno, std::system_category());
+        }
+
+        return length;
+    }
+
+    ssize_t
+    read(char* buffer, size_t size, endpoint_type& endpoint, std::error_code& ec) {
+        socklen_t endpoint_size = endpoint.capacity();
+        ssize_t length = ::recvfrom(m_fd, buffer, size, 0, endpoint.data(), &endpoint_size);
+
+        if(length == -1 && (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            ec = std::error_code(errno, std::system_category());
+        } else if(length >= 0) {
+            endpoint.resize(endpoint_size);
+        }
+
+        return length;
+    }
+
 public:
     int
     fd() const {
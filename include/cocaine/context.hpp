@@ -24,6 +24,7 @@
 #include "cocaine/common.hpp"
 #include "cocaine/dynamic.hpp"
 #include "cocaine/locked_ptr.hpp"
+#include "cocaine/logging.hpp"
 #include "cocaine/repository.hpp"
 
 #include <queue>
@@ -61,10 +62,19 @@ struct defaults {
     static const uint16_t min_port;
     static const uint16_t max_port;
 
+    // Defaults for gossip-based node discovery.
+    static const uint16_t gossip_port;
+    static const float gossip_interval;
+    static const float gossip_suspicion;
+
     // Defaults for logging service.
     struct logging {
         static const std::string verbosity;
         static const std::string timestamp;
+
+        // Asynchronous logging mode.
+        static const unsigned long queue_limit;
+        static const unsigned long sample_rate;
     };
 };
 
@@ -77,6 +87,10 @@ struct config_t {
         std::string config;
         std::string plugins;
         std::string runtime;
+
+        // NOTE: Plugin manifest cache, which enables opening the plugins lazily. It is disabled by
+        // default, because plugins might do more than registering components when initialized.
+        std::string manifest;
     } path;
 
     struct component_t {
@@ -84,6 +98,19 @@ struct config_t {
         dynamic_t   args;
     };
 
+    struct gossip_t {
+        // NOTE: Port for the membership protocol datagrams, configurable to allow multiple runtimes
+        // to run on a single machine, just like the service locator port.
+        uint16_t port;
+
+        // Protocol period and the time a suspected node has to refute the suspicion, in seconds.
+        float interval;
+        float suspicion;
+
+        // Static list of seed nodes to join the cluster via, as hostname and gossip port pairs.
+        std::vector<std::tuple<std::string, uint16_t>> peers;
+    };
+
     struct {
         std::string hostname;
         std::string uuid;
@@ -95,13 +122,25 @@ struct config_t {
         // machine. This port will be forwarded to the slaves via a command-line argument.
         uint16_t    locator;
 
+        // NOTE: Number of threads shared by the app invocation actors to accept connections. With
+        // zero, every actor gets a dedicated thread.
+        unsigned long actor_pool;
+
         boost::optional<std::string> group;
         boost::optional<std::tuple<uint16_t, uint16_t>> ports;
         boost::optional<component_t> gateway;
+
+        // NOTE: Either a multicast group or a gossip configuration might be specified for node
+        // discovery, but not both.
+        boost::optional<gossip_t> gossip;
     } network;
 
 #ifdef COCAINE_ALLOW_RAFT
     bool create_raft_cluster;
+
+    // NOTE: Directory to keep the Raft logs, terms and votes in. Without it, the Raft state lives
+    // in memory only and a restarted node has to fetch everything from the cluster once again.
+    boost::optional<std::string> raft_journal;
 #endif
 
     typedef std::map<std::string, component_t> component_map_t;
@@ -114,6 +153,10 @@ struct config_t {
             logging::priorities verbosity;
             std::string timestamp;
             blackhole::log_config_t config;
+
+            // NOTE: When specified, log records are written by a dedicated thread, so that logging
+            // doesn't block the reactor threads on the sink I/O.
+            boost::optional<logging::async_options_t> async;
         };
 
         std::map<std::string, logger_t> loggers;
@@ -161,6 +204,11 @@ class context_t {
     // A pool of execution units - threads responsible for doing all the service invocations.
     std::vector<std::unique_ptr<execution_unit_t>> m_pool;
 
+    // Reactors shared by the actors which don't use their reactors for anything but accepting the
+    // connections, so that they don't need a thread each.
+    std::vector<std::shared_ptr<io::reactor_t>> m_reactors;
+    std::vector<std::unique_ptr<io::chamber_t>> m_chambers;
+
     struct synchronization_t;
 
     // Synchronization object is responsible for tracking remote clients and sending them service
@@ -215,6 +263,15 @@ public:
     void
     attach(const std::shared_ptr<io::socket<io::tcp>>& ptr, const std::shared_ptr<io::basic_dispatch_t>& dispatch);
 
+    // Reactor for an actor which only accepts connections. The same actor name is always mapped to
+    // the same reactor of the shared pool, or a dedicated reactor is created if there's no pool.
+    auto
+    reactor(const std::string& name) -> std::shared_ptr<io::reactor_t>;
+
+    // Whether the reactor belongs to the shared pool, so that it's already running.
+    bool
+    shared(const std::shared_ptr<io::reactor_t>& reactor) const;
+
 private:
     void
     bootstrap();
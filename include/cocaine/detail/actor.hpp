@@ -52,9 +52,11 @@ class actor_t {
     // is accepted, it is assigned on a random thread from the main thread pool.
     std::list<endpoint_type> m_connectors;
 
-    // I/O authentication & processing.
+    // I/O authentication & processing. Actors running on a shared reactor have no chamber.
     std::unique_ptr<io::chamber_t> m_chamber;
 
+    bool m_running;
+
 public:
     actor_t(context_t& context, std::shared_ptr<io::reactor_t> reactor, std::unique_ptr<io::basic_dispatch_t> prototype);
     actor_t(context_t& context, std::shared_ptr<io::reactor_t> reactor, std::unique_ptr<api::service_t> service);
@@ -67,6 +69,17 @@ public:
     void
     terminate();
 
+private:
+    // Runs the function on the actor's reactor thread and waits for it to complete.
+    void
+    execute(const std::function<void()>& function);
+
+    void
+    bind(const std::vector<io::tcp::endpoint>& endpoints);
+
+    void
+    unbind();
+
 public:
     auto
     location() const -> std::vector<io::tcp::endpoint>;
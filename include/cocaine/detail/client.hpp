@@ -32,10 +32,12 @@
 #include "cocaine/asio/resolver.hpp"
 
 #include "cocaine/detail/atomic.hpp"
+#include "cocaine/locked_ptr.hpp"
 #include "cocaine/memory.hpp"
 
 #include <boost/variant.hpp>
 
+#include <algorithm>
 #include <type_traits>
 #include <utility>
 
@@ -48,6 +50,8 @@ public:
     typedef cocaine::io::channel<cocaine::io::socket<cocaine::io::tcp>>
             stream_t;
 
+    typedef std::function<void(const std::error_code&)> error_handler_t;
+
     client_t(std::unique_ptr<stream_t>&& s) {
         m_on_error = std::make_shared<std::function<void(const std::error_code&)>>(
             std::bind(&client_t::on_error, this, std::placeholders::_1)
@@ -70,6 +74,27 @@ public:
         m_error_handler = error_handler;
     }
 
+    // Unlike bind(), allows multiple users to be notified about the connection errors, which is
+    // needed for pooled connections. The handler is active while the returned pointer is alive.
+    std::shared_ptr<error_handler_t>
+    subscribe(const error_handler_t& error_handler) {
+        auto handler = std::make_shared<error_handler_t>(error_handler);
+
+        m_subscribers.erase(
+            std::remove_if(m_subscribers.begin(), m_subscribers.end(), expired()),
+            m_subscribers.end()
+        );
+
+        m_subscribers.push_back(handler);
+
+        return handler;
+    }
+
+    bool
+    connected() const {
+        return static_cast<bool>(m_session);
+    }
+
     void
     unbind() {
         auto session = std::move(m_session);
@@ -99,25 +124,277 @@ private:
     void
     on_error(const std::error_code& ec) {
         auto error_handler = m_error_handler;
+        auto subscribers = std::move(m_subscribers);
 
         unbind();
 
         if (error_handler) {
             error_handler(ec);
         }
+
+        for(auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+            auto handler = it->lock();
+
+            if(handler) {
+                (*handler)(ec);
+            }
+        }
     }
 
+    struct expired {
+        bool
+        operator()(const std::weak_ptr<error_handler_t>& handler) const {
+            return handler.expired();
+        }
+    };
+
 private:
     std::shared_ptr<session_t> m_session;
 
     std::function<void(const std::error_code&)> m_error_handler;
     std::shared_ptr<std::function<void(const std::error_code&)>> m_on_error;
+
+    std::vector<std::weak_ptr<error_handler_t>> m_subscribers;
+};
+
+// Shares client connections between all the users on the same reactor, so that many logical
+// channels are multiplexed over a single session per endpoint. Idle connections are closed after
+// a while, and failing endpoints are not reconnected to until an exponential backoff expires.
+class client_pool_t:
+    public std::enable_shared_from_this<client_pool_t>
+{
+    COCAINE_DECLARE_NONCOPYABLE(client_pool_t)
+
+public:
+    typedef io::tcp::endpoint endpoint_type;
+    typedef std::vector<endpoint_type> key_type;
+
+    typedef std::function<void(const std::shared_ptr<client_t>&)> connect_handler_t;
+    typedef std::function<void(const std::error_code&)> error_handler_t;
+
+    client_pool_t(io::reactor_t& reactor, float idle_timeout = 60.0f, float max_backoff = 30.0f):
+        m_reactor(reactor),
+        m_idle_timeout(idle_timeout),
+        m_max_backoff(max_backoff),
+        m_eviction_timer(reactor.native()),
+        m_on_start(std::make_shared<std::function<void()>>(std::bind(&client_pool_t::on_start, this)))
+    {
+        m_eviction_timer.set<client_pool_t, &client_pool_t::on_eviction>(this);
+
+        // NOTE: The pool might be constructed on any thread, while the loop watchers can be safely
+        // started only on the reactor thread itself.
+        m_reactor.post(io::make_task(m_on_start));
+    }
+
+    // Returns the pool shared by all the users of the specified reactor.
+    static
+    std::shared_ptr<client_pool_t>
+    shared(io::reactor_t& reactor) {
+        typedef std::map<
+            std::weak_ptr<void>,
+            std::weak_ptr<client_pool_t>,
+            std::owner_less<std::weak_ptr<void>>
+        > pool_map_t;
+
+        static synchronized<pool_map_t> pools;
+
+        auto locked = pools.synchronize();
+        auto pool = (*locked)[reactor.lifetime()].lock();
+
+        if(!pool) {
+            // NOTE: Pools are keyed by the reactor lifetime, so that the entries of the destroyed
+            // reactors expire instead of being picked up by a new reactor at the same address.
+            for(auto it = locked->begin(); it != locked->end();) {
+                if(it->first.expired() || it->second.expired()) {
+                    locked->erase(it++);
+                } else {
+                    ++it;
+                }
+            }
+
+            pool = std::make_shared<client_pool_t>(reactor);
+
+            (*locked)[reactor.lifetime()] = pool;
+        }
+
+        return pool;
+    }
+
+    // Connects to the first available endpoint or reuses an existing connection. Handlers are
+    // invoked via the reactor, and only if the caller still holds the handler pointers by then.
+    void
+    connect(const key_type& endpoints,
+            const std::shared_ptr<connect_handler_t>& handler,
+            const std::shared_ptr<error_handler_t>& error_handler)
+    {
+        const ev::tstamp now = m_reactor.native().now();
+
+        entry_t& entry = m_entries[endpoints];
+
+        entry.touched = now;
+
+        if(entry.client && !entry.client->connected()) {
+            // The connection has been lost since the last use.
+            entry.client.reset();
+        }
+
+        if(entry.client) {
+            m_reactor.post(std::bind(io::make_task(handler), entry.client));
+            return;
+        }
+
+        if(!entry.connector && entry.failures && now < entry.retry) {
+            m_reactor.post(std::bind(io::make_task(error_handler), entry.error));
+            return;
+        }
+
+        entry.waiters.emplace_back(handler, error_handler);
+
+        if(!entry.connector) {
+            using namespace std::placeholders;
+
+            entry.connector = std::make_shared<io::connector<io::socket<io::tcp>>>(m_reactor, endpoints);
+            entry.connector->bind(std::bind(&client_pool_t::on_connected, this, endpoints, _1),
+                                  std::bind(&client_pool_t::on_connection_error, this, endpoints, _1));
+        }
+    }
+
+private:
+    typedef std::pair<
+        std::weak_ptr<connect_handler_t>,
+        std::weak_ptr<error_handler_t>
+    > waiter_t;
+
+    struct entry_t {
+        entry_t():
+            failures(0),
+            retry(0),
+            touched(0)
+        { }
+
+        std::shared_ptr<client_t> client;
+        std::shared_ptr<io::connector<io::socket<io::tcp>>> connector;
+
+        // Users waiting for the connection to be established.
+        std::vector<waiter_t> waiters;
+
+        // Consecutive connection failures, the time when reconnecting is allowed again and the
+        // last connection error to report until then.
+        unsigned int failures;
+        ev::tstamp retry;
+        std::error_code error;
+
+        // Last time the connection has been requested.
+        ev::tstamp touched;
+    };
+
+    void
+    on_connected(const key_type& endpoints, const std::shared_ptr<io::socket<io::tcp>>& socket) {
+        auto it = m_entries.find(endpoints);
+
+        if(it == m_entries.end()) {
+            return;
+        }
+
+        entry_t& entry = it->second;
+
+        auto channel = std::make_unique<io::channel<io::socket<io::tcp>>>(m_reactor, socket);
+        auto client  = std::make_shared<client_t>(std::move(channel));
+
+        entry.client = client;
+        entry.connector.reset();
+        entry.failures = 0;
+
+        std::vector<waiter_t> waiters;
+
+        waiters.swap(entry.waiters);
+
+        // NOTE: Keep the pool alive in case some handler happens to drop the last reference to it.
+        auto self = shared_from_this();
+
+        for(auto waiter = waiters.begin(); waiter != waiters.end(); ++waiter) {
+            auto handler = waiter->first.lock();
+
+            if(handler) {
+                (*handler)(client);
+            }
+        }
+    }
+
+    void
+    on_connection_error(const key_type& endpoints, const std::error_code& ec) {
+        auto it = m_entries.find(endpoints);
+
+        if(it == m_entries.end()) {
+            return;
+        }
+
+        entry_t& entry = it->second;
+
+        const float backoff = std::min(m_max_backoff, 0.5f * (1 << std::min(entry.failures, 16u)));
+
+        entry.connector.reset();
+        entry.failures++;
+        entry.retry = m_reactor.native().now() + backoff;
+        entry.error = ec;
+
+        std::vector<waiter_t> waiters;
+
+        waiters.swap(entry.waiters);
+
+        auto self = shared_from_this();
+
+        for(auto waiter = waiters.begin(); waiter != waiters.end(); ++waiter) {
+            auto handler = waiter->second.lock();
+
+            if(handler) {
+                (*handler)(ec);
+            }
+        }
+    }
+
+    void
+    on_start() {
+        m_eviction_timer.start(m_idle_timeout, m_idle_timeout);
+    }
+
+    void
+    on_eviction(ev::timer&, int) {
+        const ev::tstamp now = m_reactor.native().now();
+
+        for(auto it = m_entries.begin(); it != m_entries.end();) {
+            const entry_t& entry = it->second;
+
+            // NOTE: Connections which are not referenced by anyone except the pool are idle.
+            const bool idle = !entry.client || entry.client.use_count() == 1 || !entry.client->connected();
+
+            if(!entry.connector && idle && now - entry.touched > m_idle_timeout) {
+                m_entries.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+private:
+    io::reactor_t& m_reactor;
+
+    const float m_idle_timeout;
+    const float m_max_backoff;
+
+    std::map<key_type, entry_t> m_entries;
+
+    ev::timer m_eviction_timer;
+
+    // Starts the eviction timer on the reactor thread, unless the pool is gone by then.
+    std::shared_ptr<std::function<void()>> m_on_start;
 };
 
 class service_resolver_t {
     COCAINE_DECLARE_NONCOPYABLE(service_resolver_t)
 
     typedef std::function<void(const std::error_code&)> error_handler_t;
+    typedef client_pool_t::connect_handler_t connect_handler_t;
 
 public:
     typedef io::tcp::endpoint endpoint_type;
@@ -126,6 +403,7 @@ public:
                        const std::vector<endpoint_type>& locator,
                        const std::string& service):
         m_reactor(reactor),
+        m_pool(client_pool_t::shared(reactor)),
         m_locator(locator),
         m_service(service)
     { }
@@ -137,25 +415,39 @@ public:
     template<class Handler, class ErrorHandler>
     void
     bind(Handler callback, ErrorHandler error_handler) {
+        using namespace std::placeholders;
+
         m_callback = callback;
         m_error_handler = std::make_shared<error_handler_t>(error_handler);
 
-        using namespace std::placeholders;
+        m_on_locator_connected = std::make_shared<connect_handler_t>(
+            std::bind(&service_resolver_t::on_locator_connected, this, _1)
+        );
+
+        m_on_service_connected = std::make_shared<connect_handler_t>(
+            std::bind(&service_resolver_t::on_service_connected, this, _1)
+        );
+
+        m_on_connection_error = std::make_shared<error_handler_t>(
+            std::bind(&service_resolver_t::on_connection_error, this, _1)
+        );
 
-        m_connector = std::make_shared<io::connector<io::socket<io::tcp>>>(m_reactor, m_locator);
-        m_connector->bind(std::bind(&service_resolver_t::on_locator_connected, this, _1),
-                          std::bind(&service_resolver_t::on_connection_error, this, _1));
+        m_pool->connect(m_locator, m_on_locator_connected, m_on_connection_error);
     }
 
     void
     unbind() {
-        m_connector.reset();
+        // Pending pool requests are canceled by dropping their handlers.
+        m_on_locator_connected.reset();
+        m_on_service_connected.reset();
+        m_on_connection_error.reset();
 
         if(m_resolve_upstream) {
             m_resolve_upstream->revoke();
             m_resolve_upstream.reset();
         }
 
+        m_locator_subscription.reset();
         m_locator_client.reset();
 
         m_callback = nullptr;
@@ -200,16 +492,10 @@ private:
                 return;
             }
 
-            m_resolver.m_connector = std::make_shared<io::connector<io::socket<io::tcp>>>(
-                m_resolver.m_reactor,
-                endpoints
-            );
-
-            using namespace std::placeholders;
-
-            m_resolver.m_connector->bind(
-                std::bind(&service_resolver_t::on_service_connected, &m_resolver, _1),
-                std::bind(&service_resolver_t::on_connection_error, &m_resolver, _1)
+            m_resolver.m_pool->connect(
+                endpoints,
+                m_resolver.m_on_service_connected,
+                m_resolver.m_on_connection_error
             );
 
             m_resolver.m_resolve_upstream->revoke();
@@ -240,13 +526,9 @@ private:
     };
 
     void
-    on_locator_connected(const std::shared_ptr<io::socket<io::tcp>>& socket) {
-        m_connector.reset();
-
-        auto channel = std::make_unique<io::channel<io::socket<io::tcp>>>(m_reactor, socket);
-        m_locator_client = std::make_shared<client_t>(std::move(channel));
-
-        m_locator_client->bind(*m_error_handler);
+    on_locator_connected(const std::shared_ptr<client_t>& client) {
+        m_locator_client = client;
+        m_locator_subscription = m_locator_client->subscribe(*m_error_handler);
 
         m_resolve_upstream = m_locator_client->call<cocaine::io::locator::resolve>(
             std::make_shared<resolve_dispatch_t>(*this),
@@ -255,20 +537,13 @@ private:
     }
 
     void
-    on_service_connected(const std::shared_ptr<io::socket<io::tcp>>& socket) {
-        m_connector.reset();
-
-        auto channel = std::make_unique<io::channel<io::socket<io::tcp>>>(m_reactor, socket);
-        auto client = std::make_shared<client_t>(std::move(channel));
-
+    on_service_connected(const std::shared_ptr<client_t>& client) {
         auto callback = m_callback;
         callback(client);
     }
 
     void
     on_connection_error(const std::error_code& ec) {
-        m_connector.reset();
-
         auto error_handler = m_error_handler;
         (*error_handler)(ec);
     }
@@ -276,13 +551,20 @@ private:
 private:
     io::reactor_t& m_reactor;
 
+    // NOTE: Both the locator and the service connections are shared with other users.
+    const std::shared_ptr<client_pool_t> m_pool;
+
     std::vector<endpoint_type> m_locator;
     std::string m_service;
 
-    std::shared_ptr<io::connector<io::socket<io::tcp>>> m_connector;
     std::shared_ptr<client_t> m_locator_client;
+    std::shared_ptr<error_handler_t> m_locator_subscription;
     std::shared_ptr<io::basic_upstream_t> m_resolve_upstream;
 
+    std::shared_ptr<connect_handler_t> m_on_locator_connected;
+    std::shared_ptr<connect_handler_t> m_on_service_connected;
+    std::shared_ptr<error_handler_t> m_on_connection_error;
+
     std::function<void(const std::shared_ptr<client_t>&)> m_callback;
     std::shared_ptr<error_handler_t> m_error_handler;
 };
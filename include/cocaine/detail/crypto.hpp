@@ -22,9 +22,12 @@
 #define COCAINE_AUTH_HPP
 
 #include "cocaine/common.hpp"
+#include "cocaine/locked_ptr.hpp"
 
 #include "cocaine/api/storage.hpp"
 
+#include <chrono>
+
 #define PROTOTYPES
 
 #include <mutils/mincludes.h>
@@ -41,16 +44,84 @@ class crypto {
 
     typename api::category_traits<api::storage_t>::ptr_type m_store;
 
+#if defined(__clang__) || defined(HAVE_GCC47)
+    typedef std::chrono::steady_clock clock_type;
+#else
+    typedef std::chrono::monotonic_clock clock_type;
+#endif
+
+    struct token_t {
+        std::string value;
+
+        // The token is fetched from the storage again after this moment, so that the changed tokens
+        // are picked up even when nobody invalidates them.
+        clock_type::time_point expires;
+    };
+
+    // Security tokens fetched from the storage so far, so that signing doesn't hit the storage for
+    // every message.
+    mutable synchronized<std::map<std::string, token_t>> m_tokens;
+
+public:
+    // Incremental HMAC computation for messages which arrive in multiple chunks.
+    class signer_t {
+        COCAINE_DECLARE_NONCOPYABLE(signer_t)
+
+    public:
+        explicit
+        signer_t(const std::string& token);
+
+        signer_t(signer_t&& other);
+
+       ~signer_t();
+
+        void
+        update(const char* data, size_t size);
+
+        void
+        update(const std::string& chunk) {
+            update(chunk.data(), chunk.size());
+        }
+
+        // The signer can't be updated anymore after the digest is computed.
+        std::string
+        digest();
+
+    private:
+        MHASH m_thread;
+    };
+
 public:
     crypto(context_t& context, const std::string& service);
    ~crypto();
 
     std::string
     sign(const std::string& message, const std::string& token_id) const;
+
+    // Starts signing a message with the specified token, the message is fed into the signer chunk
+    // by chunk.
+    signer_t
+    signer(const std::string& token_id) const;
+
+    // Drops the cached token, e.g. when it has been changed in the storage.
+    void
+    invalidate(const std::string& token_id);
+
+    // Drops all the cached tokens.
+    void
+    invalidate();
+
+private:
+    std::string
+    token(const std::string& token_id) const;
 };
 
 typedef crypto<MHASH_MD5> crypto_t;
 
+// NOTE: Signatures made with this one can't be verified by the MD5 peers, so the services have to
+// be switched to it explicitly, along with their clients.
+typedef crypto<MHASH_SHA256> crypto_sha256_t;
+
 } // namespace cocaine
 
 #endif
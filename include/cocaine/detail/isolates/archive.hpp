@@ -23,6 +23,8 @@
 
 #include "cocaine/common.hpp"
 
+#include "cocaine/api/storage.hpp"
+
 struct archive;
 
 namespace cocaine {
@@ -36,11 +38,14 @@ struct archive_error_t:
 class archive_t {
     const std::unique_ptr<logging::log_t> m_log;
 
+    // The archive data, which is read in place and has to outlive the source archive.
+    const api::blob_t m_blob;
+
     // The source archive.
     archive* m_archive;
 
 public:
-    archive_t(context_t& context, const std::string& archive);
+    archive_t(context_t& context, const api::blob_t& blob);
    ~archive_t();
 
     void
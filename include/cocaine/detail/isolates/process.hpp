@@ -44,6 +44,12 @@ class process_t:
     // Spooling target directory.
     const boost::filesystem::path m_working_directory;
 
+    // Extracted archives, named after the digests of their contents.
+    const boost::filesystem::path m_spool_cache;
+
+    // Whether the app never modifies its files, so that they can be hard linked to the cache.
+    const bool m_read_only;
+
 #ifdef COCAINE_ALLOW_CGROUPS
     // Control group handle.
     cgroup* m_cgroup;
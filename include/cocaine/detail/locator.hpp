@@ -29,6 +29,8 @@
 #include "cocaine/rpc/dispatch.hpp"
 #include "cocaine/rpc/result_of.hpp"
 
+#include <set>
+
 namespace ev {
     struct io;
     struct timer;
@@ -36,6 +38,10 @@ namespace ev {
 
 namespace cocaine {
 
+namespace io {
+    struct chamber_t;
+}
+
 class session_t;
 
 class locator_t:
@@ -60,6 +66,28 @@ class locator_t:
     // disambiguate between different runtime instances on the same host.
     std::map<remote_id_t, std::shared_ptr<session_t>> m_remotes;
 
+    // Remote nodes which are being connected to right now.
+    std::set<remote_id_t> m_linking;
+
+    struct backoff_t {
+        // Time of the next connection attempt, and the delay to wait after the next failure.
+        double retry;
+        double delay;
+    };
+
+    // Remote nodes which have failed to be connected to, they are not retried until the backoff
+    // delay expires, no matter how often they are announced.
+    std::map<remote_id_t, backoff_t> m_backoff;
+
+    // Hostnames are resolved and remote nodes are connected to on this thread, so that slow DNS
+    // or unreachable nodes never stall the reactor.
+    // NOTE: Chambers keep a reference to the reactor pointer, so it must be declared first.
+    std::shared_ptr<io::reactor_t> m_resolver_reactor;
+    std::unique_ptr<io::chamber_t> m_resolver;
+
+    // Expires when the locator is destroyed, so that late connection results are discarded.
+    std::shared_ptr<void> m_lifetime;
+
     // Remote gateway.
     std::unique_ptr<api::gateway_t> m_gateway;
 
@@ -72,6 +100,11 @@ class locator_t:
     // Used to resolve service names against service groups based on weights and other metrics.
     std::unique_ptr<router_t> m_router;
 
+    class gossip_t;
+
+    // Membership protocol used instead of the multicast announces when static peers are configured.
+    std::unique_ptr<gossip_t> m_gossip;
+
 public:
     typedef result_of<io::locator::resolve>::type resolve_result_type;
     typedef result_of<io::locator::refresh>::type refresh_result_type;
@@ -100,6 +133,16 @@ private:
     void
     on_announce_timer(ev::timer&, int);
 
+    void
+    link(const remote_id_t& node);
+
+    void
+    on_link(const remote_id_t& node, const std::shared_ptr<io::socket<io::tcp>>& socket,
+            const std::error_code& ec);
+
+    void
+    drop(const remote_id_t& node);
+
     // Synchronization
 
     void
@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2011-2014 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2014 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_LOG_QUEUE_HPP
+#define COCAINE_LOG_QUEUE_HPP
+
+#include "cocaine/detail/atomic.hpp"
+
+#include "cocaine/logging.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace cocaine { namespace logging {
+
+// Hands the log records over from the calling threads to a dedicated writer thread, which does all
+// the formatting and the sink I/O under the logger lock. The records are passed through a bounded
+// lock-free ring, so the calling threads never take a lock unless the writer has to be woken up.
+class log_queue_t {
+    COCAINE_DECLARE_NONCOPYABLE(log_queue_t)
+
+public:
+    typedef blackhole::log::record_t record_type;
+
+    log_queue_t(blackhole::synchronized<logger_t>& logger, const async_options_t& options);
+
+    // Writes all the queued records out before returning.
+   ~log_queue_t();
+
+    // Checks whether a record of the specified severity should be logged at all. In the sampling
+    // mode, only a fraction of the debug and info records is admitted when the ring is half full.
+    bool
+    admit(priorities level);
+
+    void
+    push(record_type&& record);
+
+    // Claims the cells for the whole batch at once, if it fits into the ring, and falls back to
+    // pushing the records one by one otherwise.
+    void
+    push(std::vector<record_type>&& records);
+
+    // Number of records dropped due to the ring overflow.
+    uint64_t
+    dropped() const;
+
+private:
+    struct cell_t {
+        std::atomic<size_t> sequence;
+        record_type record;
+    };
+
+    bool
+    try_push(record_type& record);
+
+    bool
+    try_push(std::vector<record_type>& records);
+
+    bool
+    try_pop(record_type& record);
+
+    size_t
+    size() const;
+
+    void
+    wakeup();
+
+    void
+    run();
+
+    // Reports the records dropped since the last report to the logger itself.
+    void
+    report_dropped();
+
+private:
+    blackhole::synchronized<logger_t>& m_logger;
+
+    const async_options_t m_options;
+
+    // The ring capacity is rounded up to a power of two, so that positions are masked, not divided.
+    const size_t m_mask;
+    const std::unique_ptr<cell_t[]> m_ring;
+
+    // Positions of the next record to push and to pop. The former is contended by the calling
+    // threads, the latter is owned by the writer thread.
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_sampled;
+
+    // Number of dropped records already reported, only touched by the writer thread.
+    uint64_t m_reported;
+
+    std::atomic<bool> m_stopped;
+
+    // The writer sleeps on this condition variable when the ring is empty.
+    std::atomic<bool> m_sleeping;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+
+    std::thread m_thread;
+};
+
+}} // namespace cocaine::logging
+
+#endif
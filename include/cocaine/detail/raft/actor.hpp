@@ -31,7 +31,10 @@
 
 #include "cocaine/platform.hpp"
 
+#include <algorithm>
+#include <deque>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <vector>
@@ -86,6 +89,46 @@ namespace detail {
         }
     };
 
+    // Applies read-only command to the state machine and provides the result to the handler.
+    template<class Event, class = void>
+    struct read_caller {
+        template<class Machine>
+        static
+        inline
+        void
+        call(Machine& machine,
+             const typename command_traits<Event>::callback_type& handler,
+             const io::aux::frozen<Event>& command)
+        {
+            auto result = machine(command);
+
+            if(handler) {
+                handler(result);
+            }
+        }
+    };
+
+    template<class Event>
+    struct read_caller<
+        Event,
+        typename std::enable_if<std::is_same<typename command_traits<Event>::value_type, void>::value>::type
+    > {
+        template<class Machine>
+        static
+        inline
+        void
+        call(Machine& machine,
+             const typename command_traits<Event>::callback_type& handler,
+             const io::aux::frozen<Event>& command)
+        {
+            machine(command);
+
+            if(handler) {
+                handler(std::error_code());
+            }
+        }
+    };
+
 } // namespace detail
 
 // Implementation of Raft actor concept (see cocaine/detail/raft/forwards.hpp).
@@ -137,6 +180,9 @@ public:
         m_log(*this, m_configuration.log(), std::move(state_machine)),
         m_cluster(*this),
         m_state(actor_state::not_in_cluster),
+        m_incoming_snapshot_entry(0, 0),
+        m_last_confirmation(0),
+        m_last_heard(0),
         m_rejoin_timer(reactor.native()),
         m_election_timer(reactor.native())
     {
@@ -297,11 +343,42 @@ public:
     }
 
     // Send command to the replicated state machine. The actor must be a leader.
+    // Commands are accumulated and pushed to the log in batches, so that concurrent clients don't
+    // pay for a separate reactor job each.
     template<class Event, class... Args>
     void
     call(const typename command_traits<Event>::callback_type& handler, Args&&... args) {
-        reactor().post(std::bind(
+        std::function<void()> command = std::bind(
             &actor::call_impl<Event>,
+            this,
+            handler,
+            io::aux::make_frozen<Event>(std::forward<Args>(args)...)
+        );
+
+        bool schedule = false;
+
+        {
+            auto pending = m_pending_calls.synchronize();
+
+            // The batch is already scheduled if there are some pending commands.
+            schedule = pending->empty();
+            pending->push_back(std::move(command));
+        }
+
+        if(schedule) {
+            reactor().post(std::bind(&actor::flush_calls, this->shared_from_this()));
+        }
+    }
+
+    // Perform read-only command on the replicated state machine without writing it to the log.
+    // The actor must be a leader. The command is applied, when the leader has caught up with the
+    // commit index at the moment of the request and its lease covers that moment, i.e. a quorum
+    // has confirmed the leadership recently enough (ReadIndex with leader leases).
+    template<class Event, class... Args>
+    void
+    read(const typename command_traits<Event>::callback_type& handler, Args&&... args) {
+        reactor().post(std::bind(
+            &actor::read_impl<Event>,
             this->shared_from_this(),
             handler,
             io::aux::make_frozen<Event>(std::forward<Args>(args)...)
@@ -372,6 +449,39 @@ private:
         }
     }
 
+    // Push the pending commands to the log. At most options().message_size commands are pushed at
+    // once, the rest are left for the next reactor iteration to not starve the I/O.
+    void
+    flush_calls() {
+        std::vector<std::function<void()>> batch;
+
+        bool reschedule = false;
+
+        {
+            auto pending = m_pending_calls.synchronize();
+
+            const size_t size = std::min<size_t>(pending->size(), std::max(1u, options().message_size));
+
+            batch.reserve(size);
+
+            std::move(pending->begin(), pending->begin() + size, std::back_inserter(batch));
+            pending->erase(pending->begin(), pending->begin() + size);
+
+            reschedule = !pending->empty();
+        }
+
+        if(reschedule) {
+            reactor().post(std::bind(&actor::flush_calls, this->shared_from_this()));
+        }
+
+        COCAINE_LOG_DEBUG(m_logger, "pushing a batch of %d commands to the log", batch.size());
+
+        // All the entries are replicated at once, when the event loop becomes idle.
+        for(auto it = batch.begin(); it != batch.end(); ++it) {
+            (*it)();
+        }
+    }
+
     // Add new command to the log.
     template<class Event>
     void
@@ -389,6 +499,129 @@ private:
         log().template bind_last<Event>(handler);
     }
 
+    // Lease reads.
+
+    template<class Event>
+    void
+    read_impl(const typename command_traits<Event>::callback_type& handler,
+              const io::aux::frozen<Event>& command)
+    {
+        if(!is_leader()) {
+            if(handler) {
+                handler(std::error_code(raft_errc::not_leader));
+            }
+            return;
+        }
+
+        // Until the leader commits an entry from its term, it doesn't know the actual commit index.
+        // But it's known to be not greater than the last index, as the leader pushes NOP entry
+        // at the beginning of the term.
+        const uint64_t read_index = committed_current_term() ? config().commit_index()
+                                                             : log().last_index();
+
+        pending_read_t read = {
+            read_index,
+            reactor().native().now(),
+            std::bind(&actor::complete_read<Event>, this, handler, command, std::placeholders::_1)
+        };
+
+        m_pending_reads.push_back(std::move(read));
+
+        process_reads();
+    }
+
+    template<class Event>
+    void
+    complete_read(const typename command_traits<Event>::callback_type& handler,
+                  const io::aux::frozen<Event>& command,
+                  const std::error_code& ec)
+    {
+        if(ec) {
+            if(handler) {
+                handler(ec);
+            }
+            return;
+        }
+
+        try {
+            detail::read_caller<Event>::call(log().machine(), handler, command);
+        } catch(const std::exception& e) {
+            COCAINE_LOG_WARNING(m_logger, "unable to apply read-only command: %s", e.what());
+
+            if(handler) {
+                handler(std::error_code(raft_errc::unknown));
+            }
+        }
+    }
+
+    bool
+    committed_current_term() const {
+        const uint64_t commit_index = config().commit_index();
+
+        if(commit_index <= log().snapshot_index()) {
+            return log().snapshot_term() == config().current_term();
+        } else {
+            return log()[commit_index].term() == config().current_term();
+        }
+    }
+
+    // Followers don't vote during the election timeout since they've heard from the leader. Leave
+    // some margin for the clock drift between the nodes.
+    ev::tstamp
+    lease_duration() const {
+        return 0.9 * options().election_timeout / 1000.0;
+    }
+
+    // Serve the pending reads, which are ready. Called whenever the lease might be extended or some
+    // entries are applied.
+    void
+    process_reads() {
+        if(m_pending_reads.empty()) {
+            return;
+        }
+
+        if(!is_leader()) {
+            fail_reads(std::error_code(raft_errc::not_leader));
+            return;
+        }
+
+        const ev::tstamp lease_end = m_cluster.lease_start() + lease_duration();
+
+        // Reads are queued in order of both the requests time and the read index.
+        while(!m_pending_reads.empty()) {
+            const pending_read_t& read = m_pending_reads.front();
+
+            if(read.requested >= lease_end || config().last_applied() < read.read_index) {
+                break;
+            }
+
+            auto complete = std::move(m_pending_reads.front().complete);
+            m_pending_reads.pop_front();
+
+            complete(std::error_code());
+        }
+
+        // The lease doesn't cover the oldest read, so ask the followers to confirm the leadership.
+        // Their responses will extend the lease, unless the leader is deposed.
+        if(!m_pending_reads.empty() &&
+           m_pending_reads.front().requested >= lease_end &&
+           m_pending_reads.front().requested > m_last_confirmation)
+        {
+            m_last_confirmation = reactor().native().now();
+            m_cluster.confirm_leadership();
+        }
+    }
+
+    void
+    fail_reads(const std::error_code& ec) {
+        std::deque<pending_read_t> reads;
+        reads.swap(m_pending_reads);
+
+        for(auto it = reads.begin(); it != reads.end(); ++it) {
+            it->complete(ec);
+        }
+    }
+
     // Interface implementation.
     template<class T>
     static
@@ -431,27 +664,28 @@ private:
     }
 
     virtual
-    deferred<std::tuple<uint64_t, bool>>
+    deferred<std::tuple<uint64_t, bool, uint64_t>>
     apply(uint64_t term,
           node_id_t leader,
           std::tuple<uint64_t, uint64_t> snapshot_entry, // index, term
-          const msgpack::object& snapshot,
+          uint64_t offset,
+          const std::string& chunk,
+          bool done,
           uint64_t commit_index)
     {
-        snapshot_type unpacked;
-        io::type_traits<snapshot_type>::unpack(snapshot, unpacked);
-
-        deferred<std::tuple<uint64_t, bool>> promise;
-        std::function<std::tuple<uint64_t, bool>()> producer = std::bind(
+        deferred<std::tuple<uint64_t, bool, uint64_t>> promise;
+        std::function<std::tuple<uint64_t, bool, uint64_t>()> producer = std::bind(
             &actor::apply_impl,
             this->shared_from_this(),
             term,
             leader,
             snapshot_entry,
-            unpacked,
+            offset,
+            chunk,
+            done,
             commit_index
         );
-        reactor().post(std::bind(&actor::deferred_pipe<std::tuple<uint64_t, bool>>,
+        reactor().post(std::bind(&actor::deferred_pipe<std::tuple<uint64_t, bool, uint64_t>>,
                                  promise,
                                  std::move(producer)));
         return promise;
@@ -477,6 +711,33 @@ private:
         return promise;
     }
 
+    virtual
+    void
+    heartbeat(uint64_t term,
+              node_id_t leader,
+              std::tuple<uint64_t, uint64_t> prev_entry, // index, term
+              uint64_t commit_index,
+              const std::function<void(const std::tuple<uint64_t, bool>&)>& callback)
+    {
+        reactor().post(std::bind(&actor::heartbeat_impl,
+                                 this->shared_from_this(),
+                                 term,
+                                 leader,
+                                 prev_entry,
+                                 commit_index,
+                                 callback));
+    }
+
+    void
+    heartbeat_impl(uint64_t term,
+                   node_id_t leader,
+                   std::tuple<uint64_t, uint64_t> prev_entry, // index, term
+                   uint64_t commit_index,
+                   const std::function<void(const std::tuple<uint64_t, bool>&)>& callback)
+    {
+        callback(append_impl(term, leader, prev_entry, std::vector<entry_type>(), commit_index));
+    }
+
     void
     deferred_setter(deferred<command_result<void>> promise, const std::error_code& ec) {
         if(ec) {
@@ -584,6 +845,7 @@ private:
 
         m_state = actor_state::follower;
         *m_leader.synchronize() = leader;
+        m_last_heard = reactor().native().now();
 
         // Check if append is possible and oldest common entries match.
         if(log().snapshot_index() > prev_index &&
@@ -645,6 +907,9 @@ private:
             }
         }
 
+        // The leader considers the entries replicated as soon as it gets the reply.
+        log().sync();
+
         config().set_commit_index(commit_index);
 
         if(pushed_some_entries) {
@@ -659,11 +924,13 @@ private:
         return std::make_tuple(config().current_term(), true);
     }
 
-    std::tuple<uint64_t, bool>
+    std::tuple<uint64_t, bool, uint64_t>
     apply_impl(uint64_t term,
                node_id_t leader,
                std::tuple<uint64_t, uint64_t> snapshot_entry, // index, term
-               const snapshot_type& snapshot,
+               uint64_t offset,
+               const std::string& chunk,
+               bool done,
                uint64_t commit_index)
     {
         COCAINE_LOG_DEBUG(m_logger,
@@ -676,18 +943,59 @@ private:
             {"leader_term", term},
             {"snapshot_index", std::get<0>(snapshot_entry)},
             {"snapshot_term", std::get<1>(snapshot_entry)},
+            {"chunk_offset", offset},
+            {"chunk_size", chunk.size()},
             {"leader_commit_index", commit_index}
         }));
 
         // Reject stale leader.
         if(term < config().current_term()) {
-            return std::make_tuple(config().current_term(), false);
+            return std::make_tuple(config().current_term(), false, uint64_t(0));
         }
 
         step_down(term);
 
         m_state = actor_state::follower;
         *m_leader.synchronize() = leader;
+        m_last_heard = reactor().native().now();
+
+        // The leader has switched to another snapshot, so the partially received one is useless.
+        if(m_incoming_snapshot_entry != snapshot_entry) {
+            m_incoming_snapshot_entry = snapshot_entry;
+            m_incoming_snapshot.clear();
+        }
+
+        // The chunk doesn't continue the received part of the snapshot. Probably some requests were
+        // lost with the connection, so ask the leader to resume from the right place.
+        if(offset != m_incoming_snapshot.size()) {
+            return std::make_tuple(config().current_term(), false, uint64_t(m_incoming_snapshot.size()));
+        }
+
+        m_incoming_snapshot.append(chunk);
+
+        const uint64_t received = m_incoming_snapshot.size();
+
+        if(!done) {
+            return std::make_tuple(config().current_term(), true, received);
+        }
+
+        snapshot_type snapshot;
+
+        try {
+            msgpack::unpacked unpacked;
+            msgpack::unpack(&unpacked, m_incoming_snapshot.data(), m_incoming_snapshot.size());
+            io::type_traits<snapshot_type>::unpack(unpacked.get(), snapshot);
+        } catch(const std::exception& e) {
+            COCAINE_LOG_WARNING(m_logger, "unable to unpack the snapshot: %s", e.what());
+
+            // Request the whole snapshot once again.
+            m_incoming_snapshot.clear();
+            return std::make_tuple(config().current_term(), false, uint64_t(0));
+        }
+
+        // Release the memory, the snapshot is not needed in the serialized form anymore.
+        std::string().swap(m_incoming_snapshot);
+        m_incoming_snapshot_entry = std::make_tuple(0, 0);
 
         // Truncate wrong entries.
         if(std::get<0>(snapshot_entry) > log().snapshot_index() &&
@@ -701,8 +1009,11 @@ private:
 
         log().reset_snapshot(std::get<0>(snapshot_entry),
                              std::get<1>(snapshot_entry),
-                             snapshot_type(snapshot));
+                             std::move(snapshot));
         config().set_last_applied(std::get<0>(snapshot_entry) - 1);
+
+        log().sync();
+
         config().set_commit_index(commit_index);
 
         if(m_state == actor_state::not_in_cluster) {
@@ -712,7 +1023,7 @@ private:
             step_down(config().current_term());
         }
 
-        return std::make_tuple(config().current_term(), true);
+        return std::make_tuple(config().current_term(), true, received);
     }
 
     std::tuple<uint64_t, bool>
@@ -732,6 +1043,16 @@ private:
             {"last_entry_term", std::get<1>(last_entry)}
         }));
 
+        // Don't disturb the leader, which has been heard from recently: its lease relies on
+        // the followers not voting during the election timeout.
+        if(term > config().current_term() &&
+           m_state == actor_state::follower &&
+           reactor().native().now() < m_last_heard + options().election_timeout / 1000.0)
+        {
+            COCAINE_LOG_DEBUG(m_logger, "reject vote request, the leader is alive");
+            return std::make_tuple(config().current_term(), false);
+        }
+
         // Check if log of the candidate is as up to date as local log,
         // and vote was not granted to other candidate in the current term.
         if(std::get<1>(last_entry) > log().last_term() ||
@@ -740,8 +1061,8 @@ private:
         {
             step_down(term);
 
-            if(term == config().current_term() && !m_voted_for) {
-                m_voted_for = candidate;
+            if(term == config().current_term() && !config().voted_for()) {
+                config().set_voted_for(candidate);
 
                 COCAINE_LOG_DEBUG(m_logger,
                                   "in term %d vote granted to %s:%d",
@@ -773,10 +1094,8 @@ private:
                 {"term", term}
             }));
 
+            // The actor has not voted in the new term, so this also resets the vote.
             config().set_current_term(term);
-
-            // The actor has not voted in the new term.
-            m_voted_for.reset();
         }
 
         // Disable all non-follower activity.
@@ -786,6 +1105,9 @@ private:
             m_state = actor_state::candidate;
             *m_leader.synchronize() = node_id_t();
             detail::finish_leadership_caller<machine_type>::call(log().machine());
+
+            // The lease is lost, the pending reads can't be served anymore.
+            fail_reads(std::error_code(raft_errc::not_leader));
         }
 
         restart_election_timer(reelection);
@@ -846,7 +1168,7 @@ private:
         step_down(config().current_term() + 1);
 
         // Vote for self.
-        m_voted_for = context().raft().id();
+        config().set_voted_for(context().raft().id());
 
         m_state = actor_state::candidate;
 
@@ -894,8 +1216,27 @@ private:
 
     actor_state m_state;
 
-    // The node for which the actor voted in current term. The node can vote only once in one term.
-    boost::optional<node_id_t> m_voted_for;
+    // Index and term of the snapshot being received from the leader and its serialized part.
+    std::tuple<uint64_t, uint64_t> m_incoming_snapshot_entry;
+    std::string m_incoming_snapshot;
+
+    // Read-only commands waiting for the lease or for the state machine to catch up.
+    struct pending_read_t {
+        uint64_t read_index;
+        ev::tstamp requested;
+        std::function<void(const std::error_code&)> complete;
+    };
+
+    std::deque<pending_read_t> m_pending_reads;
+
+    // When the leader has asked the followers to confirm its leadership for the last time.
+    ev::tstamp m_last_confirmation;
+
+    // When the follower has heard from the leader for the last time.
+    ev::tstamp m_last_heard;
+
+    // Commands from the clients, which are not pushed to the log yet.
+    synchronized<std::deque<std::function<void()>>> m_pending_calls;
 
     // The leader from the last append message.
     // It may be incorrect and actually it's just a tip, where to find current leader.
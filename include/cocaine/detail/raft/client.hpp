@@ -115,6 +115,7 @@ private:
         reset_request();
 
         m_posted_task.reset();
+        m_client_subscription.reset();
         m_client.reset();
         m_resolver.reset();
     }
@@ -292,7 +293,9 @@ private:
         m_resolver.reset();
 
         m_client = client;
-        m_client->bind(std::bind(&disposable_client_t::on_error, this, std::placeholders::_1));
+        m_client_subscription = m_client->subscribe(
+            std::bind(&disposable_client_t::on_error, this, std::placeholders::_1)
+        );
 
         m_request_sender();
     }
@@ -369,6 +372,8 @@ private:
 
     std::shared_ptr<cocaine::client_t> m_client;
 
+    std::shared_ptr<cocaine::client_t::error_handler_t> m_client_subscription;
+
     std::shared_ptr<service_resolver_t> m_resolver;
 
     std::shared_ptr<io::basic_upstream_t> m_current_request;
@@ -203,6 +203,32 @@ public:
         }
     }
 
+    // Time, by which a quorum of the cluster has acknowledged the current leadership. No other
+    // leader can be elected until (lease_start() + election_timeout), because followers don't vote
+    // while they hear from the leader.
+    ev::tstamp
+    lease_start() {
+        ev::tstamp acknowledged = get_acknowledged(m_current);
+
+        if(m_next.size() != 0) {
+            acknowledged = std::min(acknowledged, get_acknowledged(m_next));
+        }
+
+        return acknowledged;
+    }
+
+    // Send heartbeats to all the followers to extend the lease.
+    void
+    confirm_leadership() {
+        for(auto it = m_current.begin(); it != m_current.end(); ++it) {
+            (*it)->confirm_leadership();
+        }
+
+        for(auto it = m_next.begin(); it != m_next.end(); ++it) {
+            (*it)->confirm_leadership();
+        }
+    }
+
     // Check if the node has won in the current term.
     void
     register_vote() {
@@ -315,6 +341,31 @@ private:
         return nodes[pivot]->match_index();
     }
 
+    static
+    bool
+    compare_acknowledged(const std::shared_ptr<remote_type>& left,
+                         const std::shared_ptr<remote_type>& right)
+    {
+        return left->acknowledged() < right->acknowledged();
+    }
+
+    // Compute the latest time acknowledged by a quorum of set of nodes, just like get_committed().
+    ev::tstamp
+    get_acknowledged(std::vector<std::shared_ptr<remote_type>> &nodes) {
+        if(nodes.size() == 0) {
+            return 0;
+        }
+
+        size_t pivot = (nodes.size() - 1) / 2;
+
+        std::nth_element(nodes.begin(),
+                         nodes.begin() + pivot,
+                         nodes.end(),
+                         &cluster::compare_acknowledged);
+
+        return nodes[pivot]->acknowledged();
+    }
+
     // Check if majority of set of nodes has voted for us in the current term.
     bool
     won_elections(const std::vector<std::shared_ptr<remote_type>> &nodes) {
@@ -350,6 +401,10 @@ private:
     replicate_impl(ev::idle&, int) {
         m_replicator.stop();
 
+        // Group commit: entries pushed since the last iteration become durable at once, before the
+        // leader counts them as replicated to itself or sends them to anyone.
+        m_actor.log().sync();
+
         for(auto it = m_current.begin(); it != m_current.end(); ++it) {
             (*it)->replicate();
         }
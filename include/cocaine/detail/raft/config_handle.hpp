@@ -59,11 +59,22 @@ public:
         return m_config.current_term();
     }
 
+    // Also resets the vote, as the node hasn't voted in the new term yet.
     void
     set_current_term(uint64_t value) {
         m_config.set_current_term(value);
     }
 
+    const boost::optional<node_id_t>&
+    voted_for() const {
+        return m_config.voted_for();
+    }
+
+    void
+    set_voted_for(const boost::optional<node_id_t>& value) {
+        m_config.set_voted_for(value);
+    }
+
     uint64_t
     commit_index() const {
         return m_config.commit_index();
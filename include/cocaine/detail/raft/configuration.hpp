@@ -27,12 +27,14 @@
 #include <boost/optional.hpp>
 
 #include <set>
+#include <sstream>
 
 namespace cocaine { namespace raft {
 
 // This class stores state of the Raft algorithm when it's running.
 // User can write his own implementation of this class and specialize the algorithm with it
 // (for example to store the log and the state in persistent storage).
+// The default implementation keeps everything in memory, unless it's created with a journal.
 template<class StateMachine>
 class configuration {
     COCAINE_DECLARE_NONCOPYABLE(configuration)
@@ -53,12 +55,27 @@ public:
         m_last_applied(last_applied)
     { };
 
+    // Recovers the log, the current term and the vote from the journal. The cluster is used only if
+    // the journal is empty.
+    configuration(const cluster_type& cluster, const std::shared_ptr<journal_t>& journal):
+        m_cluster(cluster),
+        m_log(journal),
+        m_current_term(0),
+        m_commit_index(0),
+        m_last_applied(0),
+        m_journal(journal)
+    {
+        recover();
+    };
+
     configuration(configuration&& other):
         m_cluster(std::move(other.m_cluster)),
         m_log(std::move(other.m_log)),
         m_current_term(other.m_current_term),
+        m_voted_for(std::move(other.m_voted_for)),
         m_commit_index(other.m_commit_index),
-        m_last_applied(other.m_last_applied)
+        m_last_applied(other.m_last_applied),
+        m_journal(std::move(other.m_journal))
     { };
 
     configuration&
@@ -66,8 +83,10 @@ public:
         m_cluster = std::move(other.m_cluster);
         m_log = std::move(other.m_log);
         m_current_term = other.m_current_term;
+        m_voted_for = std::move(other.m_voted_for);
         m_commit_index = other.m_commit_index;
         m_last_applied = other.m_last_applied;
+        m_journal = std::move(other.m_journal);
         return *this;
     }
 
@@ -96,9 +115,23 @@ public:
         return m_current_term;
     }
 
+    // The node hasn't voted in the new term yet, so the vote is reset as well.
     void
     set_current_term(uint64_t value) {
         m_current_term = value;
+        m_voted_for.reset();
+        save_state();
+    }
+
+    const boost::optional<node_id_t>&
+    voted_for() const {
+        return m_voted_for;
+    }
+
+    void
+    set_voted_for(const boost::optional<node_id_t>& value) {
+        m_voted_for = value;
+        save_state();
     }
 
     uint64_t
@@ -121,6 +154,67 @@ public:
         m_last_applied = value;
     }
 
+private:
+    typedef std::tuple<uint64_t, boost::optional<node_id_t>> state_type;
+
+    // NOTE: The term and the vote must hit the disk before the node replies to anybody, otherwise it
+    // might vote twice in the same term after a restart.
+    void
+    save_state() {
+        if(!m_journal) {
+            return;
+        }
+
+        std::ostringstream buffer;
+        msgpack::packer<std::ostringstream> packer(buffer);
+
+        io::type_traits<state_type>::pack(packer, state_type(m_current_term, m_voted_for));
+
+        m_journal->set_state(buffer.str());
+    }
+
+    void
+    recover() {
+        auto state = m_journal->state();
+
+        if(state) {
+            msgpack::unpacked unpacked;
+            state_type value;
+
+            try {
+                msgpack::unpack(&unpacked, state->data(), state->size());
+                io::type_traits<state_type>::unpack(unpacked.get(), value);
+            } catch(const std::exception& e) {
+                throw cocaine::error_t("unable to recover the raft state - %s", e.what());
+            }
+
+            std::tie(m_current_term, m_voted_for) = value;
+        }
+
+        if(m_log.empty()) {
+            return;
+        }
+
+        // The cluster is restored from the snapshot and the configuration changes stored in the log
+        // after it, just like the log handle does when these entries are pushed.
+        m_cluster = std::get<1>(m_log.snapshot());
+
+        for(uint64_t index = m_log.snapshot_index() + 1; index <= m_log.last_index(); ++index) {
+            const auto& value = m_log[index].value();
+
+            if(auto inserted = boost::get<io::aux::frozen<node_commands::insert>>(&value)) {
+                if(!m_cluster.transitional()) m_cluster.insert(std::get<0>(inserted->tuple));
+            } else if(auto erased = boost::get<io::aux::frozen<node_commands::erase>>(&value)) {
+                if(!m_cluster.transitional()) m_cluster.erase(std::get<0>(erased->tuple));
+            } else if(boost::get<io::aux::frozen<node_commands::commit>>(&value)) {
+                if(m_cluster.transitional()) m_cluster.commit();
+            }
+        }
+
+        // Entries up to the snapshot were applied before, so they are committed by definition.
+        m_commit_index = m_log.snapshot_index();
+    }
+
 private:
     // Set of nodes in the RAFT cluster.
     cluster_type m_cluster;
@@ -131,11 +225,17 @@ private:
     // Current term.
     uint64_t m_current_term;
 
+    // The node for which the actor voted in current term. The node can vote only once in one term.
+    boost::optional<node_id_t> m_voted_for;
+
     // The highest index known to be committed.
     uint64_t m_commit_index;
 
     // The last entry applied to the state machine.
     uint64_t m_last_applied;
+
+    // Durable storage for the log and the state, if any.
+    std::shared_ptr<journal_t> m_journal;
 };
 
 }} // namespace cocaine::raft
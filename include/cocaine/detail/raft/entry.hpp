@@ -28,6 +28,7 @@
 
 #include <functional>
 #include <type_traits>
+#include <vector>
 
 namespace cocaine { namespace raft {
 
@@ -316,6 +317,35 @@ private:
     bool m_disable_node;
 };
 
+// A contiguous range [first, last] of entries of some log. It's packed exactly like a vector of the
+// entries, but the entries are serialized right from the log instead of being copied first.
+template<class Log, class Entry>
+struct entry_range {
+    typedef Entry entry_type;
+
+    entry_range(const Log& log, uint64_t first, uint64_t last):
+        log(log),
+        first(first),
+        last(last)
+    { }
+
+    // NOTE: The protocol declares a vector of entries, so the range has to be convertible to it to
+    // pass the sequence type checks. The conversion copies the entries and shouldn't be used.
+    operator std::vector<entry_type>() const {
+        std::vector<entry_type> entries;
+
+        for(uint64_t i = first; i <= last; ++i) {
+            entries.push_back(log[i]);
+        }
+
+        return entries;
+    }
+
+    const Log& log;
+    const uint64_t first;
+    const uint64_t last;
+};
+
 }} // namespace cocaine::raft
 
 #endif // COCAINE_RAFT_ENTRY_HPP
@@ -41,7 +41,10 @@ enum class raft_errc {
     // State machine replies with this code on configuration changes commands,
     // when configuration is in transitional state. Configuration changes protocol allows
     // only one operation at the same time.
-    busy
+    busy,
+
+    // Node replies with this code on heartbeats addressed to state machines it doesn't run.
+    unknown_machine
 };
 
 struct raft_category_t :
@@ -61,6 +64,8 @@ struct raft_category_t :
                 return "Status of the request is unknown";
             case static_cast<int>(raft_errc::busy):
                 return "Some cluster change is in cluster";
+            case static_cast<int>(raft_errc::unknown_machine):
+                return "There is no such state machine";
             default:
                 return "Unexpected RAFT error";
         }
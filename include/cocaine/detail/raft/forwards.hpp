@@ -28,6 +28,7 @@
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
 
+#include <functional>
 #include <set>
 #include <string>
 #include <utility>
@@ -213,11 +214,13 @@ public:
            uint64_t commit_index) = 0;
 
     virtual
-    deferred<std::tuple<uint64_t, bool>>
+    deferred<std::tuple<uint64_t, bool, uint64_t>>
     apply(uint64_t term,
           node_id_t leader,
-          std::tuple<uint64_t, uint64_t> prev_entry, // index, term
-          const msgpack::object& snapshot,
+          std::tuple<uint64_t, uint64_t> snapshot_entry, // index, term
+          uint64_t offset,
+          const std::string& chunk,
+          bool done,
           uint64_t commit_index) = 0;
 
     virtual
@@ -226,6 +229,16 @@ public:
                  node_id_t candidate,
                  std::tuple<uint64_t, uint64_t> last_entry) = 0;
 
+    // Same as append without entries, but the result is provided to the callback. It's used to
+    // process heartbeats coalesced from multiple state machines.
+    virtual
+    void
+    heartbeat(uint64_t term,
+              node_id_t leader,
+              std::tuple<uint64_t, uint64_t> prev_entry, // index, term
+              uint64_t commit_index,
+              const std::function<void(const std::tuple<uint64_t, bool>&)>& callback) = 0;
+
     virtual
     deferred<command_result<void>>
     insert(const node_id_t& node) = 0;
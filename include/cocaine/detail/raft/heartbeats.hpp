@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2013-2014 Andrey Goryachev <andrey.goryachev@gmail.com>
+    Copyright (c) 2011-2014 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_RAFT_HEARTBEATS_HPP
+#define COCAINE_RAFT_HEARTBEATS_HPP
+
+#include "cocaine/detail/client.hpp"
+#include "cocaine/detail/raft/forwards.hpp"
+
+#include "cocaine/logging.hpp"
+
+#include <boost/variant.hpp>
+
+namespace cocaine { namespace raft {
+
+// Heartbeats of all the state machines, which are led by the local node and replicated to some
+// remote node. Instead of sending a separate heartbeat for every state machine, the leaders are
+// ticked by the single timer, and all their heartbeats are sent in one message, which the remote
+// node service demultiplexes to the actors. It allows to run hundreds of state machines per node.
+class heartbeat_channel_t {
+    COCAINE_DECLARE_NONCOPYABLE(heartbeat_channel_t)
+
+public:
+    typedef std::function<void()> tick_handler_t;
+
+    typedef boost::variant<std::error_code, std::tuple<uint64_t, bool>> result_type;
+    typedef std::function<void(result_type)> callback_type;
+
+    heartbeat_channel_t(context_t& context, io::reactor_t& reactor, const node_id_t& node);
+
+   ~heartbeat_channel_t();
+
+    // All the subscribers are ticked every options().heartbeat_timeout milliseconds at once, so
+    // that their heartbeats get into the same batch. The handler is active while the returned
+    // pointer is alive.
+    std::shared_ptr<tick_handler_t>
+    subscribe(const tick_handler_t& handler);
+
+    // Queues the heartbeat of the state machine. Heartbeats queued during the event loop iteration
+    // are sent together, the callback is called with the response of the particular actor.
+    void
+    send(const std::string& machine,
+         uint64_t term,
+         const node_id_t& leader,
+         const std::tuple<uint64_t, uint64_t>& prev_entry, // index, term
+         uint64_t commit_index,
+         const callback_type& callback);
+
+private:
+    typedef std::tuple<
+        std::string,
+        uint64_t,
+        node_id_t,
+        std::tuple<uint64_t, uint64_t>,
+        uint64_t
+    > heartbeat_type;
+
+    typedef boost::variant<
+        std::error_code,
+        std::tuple<std::vector<std::tuple<uint64_t, bool>>>
+    > response_type;
+
+    void
+    on_tick(ev::timer&, int);
+
+    void
+    on_flush(ev::idle&, int);
+
+    void
+    on_connected(const std::shared_ptr<client_t>& client);
+
+    void
+    on_connection_error(const std::error_code& ec);
+
+    void
+    on_error(const std::error_code& ec);
+
+    // Fails all the queued heartbeats.
+    void
+    drop_batch(const std::error_code& ec);
+
+    static
+    void
+    on_response(const std::shared_ptr<std::vector<callback_type>>& callbacks, response_type response);
+
+private:
+    context_t& m_context;
+
+    io::reactor_t& m_reactor;
+
+    const node_id_t m_node;
+
+    const std::unique_ptr<logging::log_t> m_logger;
+
+    std::vector<std::weak_ptr<tick_handler_t>> m_subscribers;
+
+    // Heartbeats queued during the current event loop iteration and their callbacks.
+    std::vector<heartbeat_type> m_batch;
+    std::vector<callback_type> m_callbacks;
+
+    std::shared_ptr<client_t> m_client;
+
+    // Connection error handler, active while this pointer is alive.
+    std::shared_ptr<client_t::error_handler_t> m_client_subscription;
+
+    std::shared_ptr<service_resolver_t> m_resolver;
+
+    ev::timer m_ticker;
+
+    // Sends the batch, when all the heartbeats of the current iteration are queued.
+    ev::idle m_flusher;
+};
+
+}} // namespace cocaine::raft
+
+#endif // COCAINE_RAFT_HEARTBEATS_HPP
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2013-2014 Andrey Goryachev <andrey.goryachev@gmail.com>
+    Copyright (c) 2011-2014 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_RAFT_JOURNAL_HPP
+#define COCAINE_RAFT_JOURNAL_HPP
+
+#include "cocaine/common.hpp"
+
+#include <boost/optional.hpp>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+
+namespace cocaine { namespace raft {
+
+// Durable storage for the Raft state of a single actor: the log entries, the latest snapshot and
+// the current term with the vote. Everything is stored as opaque checksummed records, the log and
+// the configuration are responsible for serialization.
+//
+// Log entries are appended to segment files, which are named after the index of their first entry.
+// Appends are buffered and hit the disk only on sync(), so that a single fsync() is amortized over
+// all the entries pushed during one event loop iteration. The snapshot and the term are rewritten
+// atomically and synchronously, as they are small and rarely modified.
+//
+// The journal is not thread-safe, except for the snapshot generation and store_snapshot(), which
+// let the snapshots taken in background be written out by the worker thread.
+class journal_t {
+    COCAINE_DECLARE_NONCOPYABLE(journal_t)
+
+public:
+    typedef std::function<void(uint64_t index, const char* data, size_t size)> replay_handler_t;
+
+    // Opens the journal in the specified directory, creating it if needed. Segments are validated,
+    // and torn or corrupted records at the end of the journal are dropped.
+    explicit
+    journal_t(const std::string& path);
+
+   ~journal_t();
+
+    // Recovery
+
+    boost::optional<std::string>
+    state() const;
+
+    boost::optional<std::string>
+    snapshot() const;
+
+    // Calls the handler for every stored entry in the index order. The data is only valid for the
+    // duration of the call.
+    void
+    replay(const replay_handler_t& handler) const;
+
+    // Modification
+
+    void
+    set_state(const std::string& blob);
+
+    // Stores the snapshot and drops the segments which are completely covered by it.
+    void
+    set_snapshot(uint64_t index, const std::string& blob);
+
+    // Snapshot generation, bumped by every set_snapshot() call.
+    uint64_t
+    snapshot_generation() const;
+
+    // Stores the snapshot unless some other snapshot has been set since the specified generation, and
+    // tells whether it was stored. Can be called from any thread, the covered segments are dropped
+    // later by commit_snapshot() on the journal thread.
+    bool
+    store_snapshot(uint64_t generation, const std::string& blob);
+
+    // Drops the segments which are completely covered by the snapshot stored by store_snapshot().
+    void
+    commit_snapshot(uint64_t index);
+
+    void
+    append(uint64_t index, const std::string& blob);
+
+    // Drops the entries starting with the specified index.
+    void
+    truncate(uint64_t index);
+
+    // Flushes the buffered entries and makes all the modifications durable.
+    void
+    sync();
+
+private:
+    struct segment_t {
+        uint64_t first;
+        int fd;
+
+        // Offsets of the records in the segment, including the buffered ones.
+        std::vector<off_t> offsets;
+        off_t size;
+    };
+
+    std::string
+    segment_path(uint64_t first) const;
+
+    void
+    recover(segment_t& segment, bool& corrupted);
+
+    void
+    open_segment(uint64_t first);
+
+    // Closes and removes the segment file, the caller is responsible for forgetting the segment.
+    void
+    drop_segment(const segment_t& segment);
+
+    void
+    flush();
+
+    void
+    write_record(const std::string& name, const std::string& blob);
+
+    boost::optional<std::string>
+    read_record(const std::string& name) const;
+
+private:
+    const std::string m_path;
+
+    std::deque<segment_t> m_segments;
+
+    // Records appended to the last segment, which are not written yet.
+    std::string m_buffer;
+
+    // Segments with modifications which are not synced yet.
+    std::set<int> m_dirty;
+
+    // Whether some segments were created or removed since the last sync.
+    bool m_dirty_directory;
+
+    // Serializes the snapshot writes from the journal thread and from the background workers.
+    mutable std::mutex m_snapshot_mutex;
+    uint64_t m_snapshot_generation;
+};
+
+}} // namespace cocaine::raft
+
+#endif // COCAINE_RAFT_JOURNAL_HPP
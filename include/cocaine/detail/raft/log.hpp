@@ -22,18 +22,24 @@
 #define COCAINE_RAFT_LOG_HPP
 
 #include "cocaine/detail/raft/forwards.hpp"
+#include "cocaine/detail/raft/journal.hpp"
 #include "cocaine/common.hpp"
 
+#include "cocaine/traits/raft.hpp"
+
 #include <boost/assert.hpp>
 
 #include <deque>
 #include <algorithm>
+#include <sstream>
 
 namespace cocaine { namespace raft {
 
 // This class stores log of state machine. Actually instance of this class is part of Raft configuration.
 // User can write his own implementation of this class and provide it to the algorithm through configuration (for example to store the log in persistent storage).
 // All methods of the log are called only with correct arguments and only when it has sense (i.e. snapshot() is called only after set_snapshot()).
+// If the log is created with a journal, then the entries are kept in memory as well, but every modification is written ahead
+// to the journal and becomes durable on sync(). Such a log is recovered from the journal on construction.
 template<class StateMachine, class Cluster>
 class log {
     COCAINE_DECLARE_NONCOPYABLE(log)
@@ -42,22 +48,38 @@ class log {
     typedef typename log_traits<StateMachine, Cluster>::snapshot_type snapshot_type;
     typedef std::deque<entry_type> container_type;
 
+    typedef std::tuple<uint64_t, uint64_t, snapshot_type> stored_snapshot_type;
+
 public:
     log():
-        m_first_index(0)
+        m_first_index(0),
+        m_snapshot_term(0)
     { }
 
+    explicit
+    log(const std::shared_ptr<journal_t>& journal):
+        m_first_index(0),
+        m_snapshot_term(0),
+        m_journal(journal)
+    {
+        recover();
+    }
+
     log(log&& other):
         m_first_index(other.m_first_index),
         m_entries(std::move(other.m_entries)),
-        m_snapshot(std::move(other.m_snapshot))
+        m_snapshot_term(other.m_snapshot_term),
+        m_snapshot(std::move(other.m_snapshot)),
+        m_journal(std::move(other.m_journal))
     { }
 
     log&
     operator=(log&& other) {
         m_first_index = other.m_first_index;
         m_entries = std::move(other.m_entries);
+        m_snapshot_term = other.m_snapshot_term;
         m_snapshot = std::move(other.m_snapshot);
+        m_journal = std::move(other.m_journal);
         return *this;
     }
 
@@ -98,6 +120,10 @@ public:
     void
     push(Args&&... args) {
         m_entries.emplace_back(std::forward<Args>(args)...);
+
+        if(m_journal) {
+            m_journal->append(last_index(), pack(m_entries.back()));
+        }
     }
 
     // Remove tail of the log including entry with given index.
@@ -105,6 +131,18 @@ public:
     truncate(uint64_t index) {
         BOOST_ASSERT(index >= m_first_index);
         m_entries.resize(std::min<uint64_t>(m_entries.size(), index - m_first_index));
+
+        if(m_journal) {
+            m_journal->truncate(index);
+        }
+    }
+
+    // Make all the modifications durable. Actor calls this method before acknowledging new entries.
+    void
+    sync() {
+        if(m_journal) {
+            m_journal->sync();
+        }
     }
 
     // Store snapshot of state machine in the log.
@@ -113,15 +151,37 @@ public:
     // This method must clean the log and setup given snapshot, when the snapshot is newer then last entry or older of current snapshot.
     void
     set_snapshot(uint64_t index, uint64_t term, snapshot_type&& snapshot) {
-        m_snapshot.reset(new snapshot_type(std::move(snapshot)));
+        set_snapshot_impl(index, term, std::move(snapshot), false);
+    }
 
-        if(index >= last_index() || index < m_first_index) {
-            m_entries.clear();
-        } else {
-            m_entries.erase(m_entries.begin(), m_entries.begin() + (index - m_first_index + 1));
-        }
-        m_first_index = index + 1;
-        m_snapshot_term = term;
+    // Same as set_snapshot(), but the snapshot has already been stored in the journal, see below.
+    void
+    set_stored_snapshot(uint64_t index, uint64_t term, snapshot_type&& snapshot) {
+        set_snapshot_impl(index, term, std::move(snapshot), true);
+    }
+
+    // The journal of the log, if any. Snapshots taken in background are stored in the journal right
+    // on the worker thread, framed with stored_snapshot(), so that the event loop doesn't wait for the
+    // serialization and the disk.
+    const std::shared_ptr<journal_t>&
+    journal() const {
+        return m_journal;
+    }
+
+    // Frames the packed snapshot the same way the log stores its own snapshots.
+    static
+    std::string
+    stored_snapshot(uint64_t index, uint64_t term, const std::string& packed) {
+        std::ostringstream buffer;
+        msgpack::packer<std::ostringstream> packer(buffer);
+
+        packer.pack_array(3);
+        packer << index;
+        packer << term;
+
+        buffer.write(packed.data(), packed.size());
+
+        return buffer.str();
     }
 
     // Return index of current snapshot.
@@ -145,6 +205,118 @@ public:
         return *m_snapshot;
     }
 
+private:
+    void
+    set_snapshot_impl(uint64_t index, uint64_t term, snapshot_type&& snapshot, bool stored) {
+        m_snapshot.reset(new snapshot_type(std::move(snapshot)));
+
+        const bool reset = index >= last_index() || index < m_first_index;
+
+        if(reset) {
+            m_entries.clear();
+        } else {
+            m_entries.erase(m_entries.begin(), m_entries.begin() + (index - m_first_index + 1));
+        }
+        m_first_index = index + 1;
+        m_snapshot_term = term;
+
+        if(m_journal) {
+            if(reset) {
+                m_journal->truncate(m_first_index);
+            }
+
+            if(stored) {
+                m_journal->commit_snapshot(index);
+            } else {
+                m_journal->set_snapshot(index, pack_snapshot());
+            }
+        }
+    }
+
+    template<class T>
+    static
+    std::string
+    pack(const T& value) {
+        std::ostringstream buffer;
+        msgpack::packer<std::ostringstream> packer(buffer);
+
+        io::type_traits<T>::pack(packer, value);
+
+        return buffer.str();
+    }
+
+    // Same as pack(stored_snapshot_type), but without copying the snapshot into a tuple.
+    std::string
+    pack_snapshot() const {
+        std::ostringstream buffer;
+        msgpack::packer<std::ostringstream> packer(buffer);
+
+        packer.pack_array(3);
+        packer << snapshot_index();
+        packer << m_snapshot_term;
+
+        io::type_traits<snapshot_type>::pack(packer, *m_snapshot);
+
+        return buffer.str();
+    }
+
+    template<class T>
+    static
+    void
+    unpack(const char* data, size_t size, T& value) {
+        msgpack::unpacked unpacked;
+
+        msgpack::unpack(&unpacked, data, size);
+        io::type_traits<T>::unpack(unpacked.get(), value);
+    }
+
+    void
+    recover() {
+        auto snapshot = m_journal->snapshot();
+
+        if(!snapshot) {
+            // Entries without a snapshot are useless, because the actor always starts from a snapshot.
+            m_journal->truncate(0);
+            return;
+        }
+
+        stored_snapshot_type stored;
+
+        try {
+            unpack(snapshot->data(), snapshot->size(), stored);
+        } catch(const std::exception& e) {
+            throw cocaine::error_t("unable to recover the raft snapshot - %s", e.what());
+        }
+
+        m_first_index = std::get<0>(stored) + 1;
+        m_snapshot_term = std::get<1>(stored);
+        m_snapshot.reset(new snapshot_type(std::move(std::get<2>(stored))));
+
+        m_journal->replay(std::bind(&log::replay, this, std::placeholders::_1, std::placeholders::_2,
+                                    std::placeholders::_3));
+
+        // Drop whatever is left after the last recovered entry, e.g. entries which failed to unpack.
+        m_journal->truncate(m_first_index + m_entries.size());
+    }
+
+    void
+    replay(uint64_t index, const char* data, size_t size) {
+        // Entries covered by the snapshot are still stored in the oldest segment.
+        if(index < m_first_index || index != m_first_index + m_entries.size()) {
+            return;
+        }
+
+        entry_type entry;
+
+        try {
+            unpack(data, size, entry);
+        } catch(const std::exception& e) {
+            return;
+        }
+
+        m_entries.emplace_back(std::move(entry));
+    }
+
 private:
     // Index of first entry in m_entries.
     uint64_t m_first_index;
@@ -154,6 +326,9 @@ private:
     uint64_t m_snapshot_term;
 
     std::unique_ptr<snapshot_type> m_snapshot;
+
+    // Optional durable storage for the log.
+    std::shared_ptr<journal_t> m_journal;
 };
 
 }} // namespace cocaine::raft
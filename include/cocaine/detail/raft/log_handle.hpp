@@ -23,9 +23,14 @@
 
 #include "cocaine/detail/raft/forwards.hpp"
 #include "cocaine/detail/raft/error.hpp"
+#include "cocaine/detail/raft/journal.hpp"
 
 #include "cocaine/logging.hpp"
 
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
 namespace cocaine { namespace raft {
 
 namespace detail {
@@ -53,6 +58,40 @@ namespace detail {
         }
     };
 
+    // State machine may provide a frozen view of its state, which is turned into a snapshot on
+    // a separate thread. The returned producer must not touch the mutable state of the machine,
+    // i.e. it should capture an immutable or copy-on-write view of it:
+    //     std::function<snapshot_type()> freeze() const;
+    template<class Machine, class = void>
+    struct freeze_caller {
+        typedef std::function<typename Machine::snapshot_type()> producer_type;
+
+        static
+        inline
+        producer_type
+        call(const Machine&) {
+            return producer_type();
+        }
+    };
+
+    template<class Machine>
+    struct freeze_caller<
+        Machine,
+        typename aux::require_method<
+            std::function<typename Machine::snapshot_type()>(Machine::*)() const,
+            &Machine::freeze
+        >::type
+    > {
+        typedef std::function<typename Machine::snapshot_type()> producer_type;
+
+        static
+        inline
+        producer_type
+        call(const Machine& machine) {
+            return machine.freeze();
+        }
+    };
+
 } // namespace detail
 
 // This class works with log and state machine and provides snapshotting.
@@ -66,6 +105,7 @@ class log_handle {
     typedef typename actor_type::machine_type machine_type;
     typedef typename actor_type::entry_type entry_type;
     typedef typename actor_type::snapshot_type snapshot_type;
+    typedef typename detail::freeze_caller<machine_type>::producer_type producer_type;
 
 public:
     log_handle(actor_type &actor, log_type &log, machine_type&& machine):
@@ -75,6 +115,11 @@ public:
         m_machine(std::move(machine)),
         m_next_snapshot_index(0),
         m_next_snapshot_term(0),
+        m_next_snapshot_stored(false),
+        m_taking_snapshot(false),
+        m_snapshot_pending(false),
+        m_packed_snapshot_index(0),
+        m_packed_snapshot_term(0),
         m_background_worker(actor.reactor().native())
     {
         // If the log is empty, then assume that it contains two NOP entries and create initial snapshot.
@@ -93,6 +138,12 @@ public:
         m_background_worker.set<log_handle, &log_handle::apply_entries>(this);
     }
 
+   ~log_handle() {
+        if(m_snapshot_worker) {
+            m_snapshot_worker->join();
+        }
+    }
+
     bool
     empty() const {
         return m_log.empty();
@@ -182,6 +233,12 @@ public:
         }
     }
 
+    // Make the log durable, if it's backed by persistent storage.
+    void
+    sync() {
+        m_log.sync();
+    }
+
     void
     truncate(uint64_t index) {
         // Now we don't know if truncated entries will be committed,
@@ -219,6 +276,7 @@ public:
         m_log.set_snapshot(index, term, std::move(snapshot));
         m_actor.config().set_last_applied(index - 1);
         m_next_snapshot.reset();
+        m_next_packed_snapshot.reset();
 
         m_actor.cluster().consume(std::get<1>(m_log.snapshot()));
 
@@ -247,6 +305,27 @@ public:
         return m_log.snapshot();
     }
 
+    // Serialized snapshot to be sent to stale followers. It's packed once per snapshot and shared by
+    // all the transfers, which send it in chunks.
+    std::shared_ptr<const std::string>
+    packed_snapshot() {
+        if(!m_packed_snapshot ||
+           m_packed_snapshot_index != snapshot_index() ||
+           m_packed_snapshot_term != snapshot_term())
+        {
+            std::ostringstream buffer;
+            msgpack::packer<std::ostringstream> packer(buffer);
+
+            io::type_traits<snapshot_type>::pack(packer, snapshot());
+
+            m_packed_snapshot = std::make_shared<const std::string>(buffer.str());
+            m_packed_snapshot_index = snapshot_index();
+            m_packed_snapshot_term = snapshot_term();
+        }
+
+        return m_packed_snapshot;
+    }
+
     // Notify that there is something to apply (usually it means that commit index has been increased).
     void
     apply() {
@@ -282,13 +361,190 @@ private:
             }));
 
             if(m_next_snapshot_index > snapshot_index()) {
-                m_log.set_snapshot(m_next_snapshot_index,
-                                   m_next_snapshot_term,
-                                   std::move(*m_next_snapshot));
+                // The snapshot taken in background is already in the journal, if there is one, so
+                // only the log in memory is updated here.
+                if(m_next_snapshot_stored) {
+                    m_log.set_stored_snapshot(m_next_snapshot_index,
+                                              m_next_snapshot_term,
+                                              std::move(*m_next_snapshot));
+                } else {
+                    m_log.set_snapshot(m_next_snapshot_index,
+                                       m_next_snapshot_term,
+                                       std::move(*m_next_snapshot));
+                }
+
+                // The snapshot might be already serialized by the background worker.
+                if(m_next_packed_snapshot) {
+                    m_packed_snapshot = std::move(m_next_packed_snapshot);
+                    m_packed_snapshot_index = m_next_snapshot_index;
+                    m_packed_snapshot_term = m_next_snapshot_term;
+                }
             }
 
             m_next_snapshot.reset();
+            m_next_packed_snapshot.reset();
+        }
+    }
+
+    // Take the snapshot of the state machine at the last applied entry. If the machine is able to
+    // freeze its state, the snapshot is taken and serialized in background, so that the event loop
+    // isn't blocked. Otherwise it's taken right here.
+    void
+    take_snapshot() {
+        const uint64_t index = m_actor.config().last_applied();
+        const uint64_t term = m_log[index].term();
+
+        producer_type producer = detail::freeze_caller<machine_type>::call(m_machine);
+
+        if(!producer) {
+            m_next_snapshot.reset(new snapshot_type(m_machine.snapshot(), m_actor.config().cluster()));
+            m_next_snapshot_index = index;
+            m_next_snapshot_term = term;
+            m_next_snapshot_stored = false;
+
+            update_snapshot();
+            return;
+        }
+
+        if(m_taking_snapshot) {
+            // The snapshot will be retaken as soon as the current one is complete.
+            if(!m_snapshot_pending) {
+                COCAINE_LOG_DEBUG(m_logger, "the previous snapshot is still being taken, postponing");
+                m_snapshot_pending = true;
+            }
+
+            return;
+        }
+
+        COCAINE_LOG_DEBUG(m_logger, "taking snapshot of the state machine at index %d in background", index)
+        (blackhole::attribute::list({
+            {"snapshot_index", index}
+        }));
+
+        // The previous worker has already posted its result, so it's finished or about to finish.
+        if(m_snapshot_worker) {
+            m_snapshot_worker->join();
         }
+
+        m_taking_snapshot = true;
+
+        // The worker writes the snapshot to the journal itself, unless the log gets some other
+        // snapshot in the meantime, which is detected by the snapshot generation.
+        const std::shared_ptr<journal_t>& journal = m_log.journal();
+
+        m_snapshot_worker.reset(new std::thread(std::bind(
+            &log_handle::take_snapshot_impl,
+            std::ref(m_actor.reactor()),
+            std::weak_ptr<actor_type>(m_actor.shared_from_this()),
+            producer,
+            m_actor.config().cluster(),
+            index,
+            term,
+            journal,
+            journal ? journal->snapshot_generation() : 0
+        )));
+    }
+
+    // Runs on the worker thread. It touches nothing but the frozen view of the state machine, the
+    // journal snapshot, which is safe to store from any thread, and the reactor, which outlives the
+    // worker, because the handle joins it on destruction.
+    static
+    void
+    take_snapshot_impl(io::reactor_t& reactor,
+                       std::weak_ptr<actor_type> actor,
+                       producer_type producer,
+                       typename config_type::cluster_type cluster,
+                       uint64_t index,
+                       uint64_t term,
+                       std::shared_ptr<journal_t> journal,
+                       uint64_t generation)
+    {
+        std::shared_ptr<snapshot_type> snapshot;
+        std::shared_ptr<const std::string> packed;
+
+        bool stored = false;
+
+        try {
+            snapshot = std::make_shared<snapshot_type>(producer(), std::move(cluster));
+
+            std::ostringstream buffer;
+            msgpack::packer<std::ostringstream> packer(buffer);
+
+            io::type_traits<snapshot_type>::pack(packer, *snapshot);
+
+            packed = std::make_shared<const std::string>(buffer.str());
+
+            if(journal) {
+                stored = journal->store_snapshot(generation, log_type::stored_snapshot(index, term, *packed));
+            }
+        } catch(...) {
+            snapshot.reset();
+        }
+
+        reactor.post(std::bind(&log_handle::on_snapshot_taken, actor, snapshot, packed, index, term, stored));
+    }
+
+    static
+    void
+    on_snapshot_taken(const std::weak_ptr<actor_type>& actor,
+                      const std::shared_ptr<snapshot_type>& snapshot,
+                      const std::shared_ptr<const std::string>& packed,
+                      uint64_t index,
+                      uint64_t term,
+                      bool stored)
+    {
+        if(auto ptr = actor.lock()) {
+            ptr->log().complete_snapshot(snapshot, packed, index, term, stored);
+        }
+    }
+
+    void
+    complete_snapshot(const std::shared_ptr<snapshot_type>& snapshot,
+                      const std::shared_ptr<const std::string>& packed,
+                      uint64_t index,
+                      uint64_t term,
+                      bool stored)
+    {
+        m_taking_snapshot = false;
+
+        if(!snapshot) {
+            COCAINE_LOG_WARNING(m_logger, "unable to take snapshot of the state machine at index %d", index)
+            (blackhole::attribute::list({
+                {"snapshot_index", index}
+            }));
+        } else if(index > snapshot_index()) {
+            // The log is truncated only now, when the snapshot is complete. A newer snapshot might
+            // have been received from the leader in the meantime though, then this one is dropped.
+            m_next_snapshot.reset(new snapshot_type(std::move(*snapshot)));
+            m_next_snapshot_index = index;
+            m_next_snapshot_term = term;
+            m_next_snapshot_stored = stored;
+            m_next_packed_snapshot = packed;
+
+            update_snapshot();
+        }
+
+        // The entries applied while this snapshot was being taken might be enough for the next one.
+        if(m_snapshot_pending) {
+            m_snapshot_pending = false;
+
+            if(snapshot_due()) {
+                take_snapshot();
+            }
+        }
+    }
+
+    // Whether enough entries are applied since the last snapshot, either written to the log or
+    // waiting to be written there, to take a new one.
+    bool
+    snapshot_due() const {
+        uint64_t base = snapshot_index();
+
+        if(m_next_snapshot) {
+            base = std::max(base, m_next_snapshot_index);
+        }
+
+        return m_actor.config().last_applied() >= base + m_actor.options().snapshot_threshold;
     }
 
     struct entry_visitor_t {
@@ -381,17 +637,16 @@ private:
             // If enough entries from previous snapshot are applied, then we should take new snapshot.
             // We will apply this new snapshot to the log later, when there will be enough new entries,
             // because we want to have some amount of entries in the log to replicate them to stale followers.
-            if(m_actor.config().last_applied() ==
-               snapshot_index() + m_actor.options().snapshot_threshold)
-            {
-                m_next_snapshot.reset(new snapshot_type(m_machine.snapshot(), m_actor.config().cluster()));
-                m_next_snapshot_index = m_actor.config().last_applied();
-                m_next_snapshot_term = m_log[m_actor.config().last_applied()].term();
-
-                update_snapshot();
+            // NOTE: The check is not an exact match, so that the snapshot is still taken when the
+            // threshold is crossed while a snapshot was being received or postponed.
+            if(snapshot_due()) {
+                take_snapshot();
             }
         }
 
+        // The state machine has caught up a bit, probably some reads can be served now.
+        m_actor.process_reads();
+
         if(last_index() <= m_actor.config().last_applied()) {
             detail::complete_log_caller<machine_type>::call(m_machine);
         }
@@ -416,6 +671,27 @@ private:
 
     uint64_t m_next_snapshot_term;
 
+    // Whether the next snapshot has already been stored in the journal by the background worker.
+    bool m_next_snapshot_stored;
+
+    // Serialized form of the next snapshot, if it was taken in background.
+    std::shared_ptr<const std::string> m_next_packed_snapshot;
+
+    // Worker thread, which takes snapshots of the state machine in background.
+    std::unique_ptr<std::thread> m_snapshot_worker;
+
+    bool m_taking_snapshot;
+
+    // Set when a snapshot was requested while the previous one was still being taken.
+    bool m_snapshot_pending;
+
+    // Cached result of packed_snapshot().
+    std::shared_ptr<const std::string> m_packed_snapshot;
+
+    uint64_t m_packed_snapshot_index;
+
+    uint64_t m_packed_snapshot_term;
+
     // This watcher applies committed entries in background.
     ev::idle m_background_worker;
 
@@ -58,12 +58,14 @@ private:
            const std::vector<msgpack::object>& entries,
            uint64_t commit_index);
 
-    deferred<std::tuple<uint64_t, bool>>
+    deferred<std::tuple<uint64_t, bool, uint64_t>>
     apply(const std::string& state_machine,
           uint64_t term,
           raft::node_id_t leader,
           std::tuple<uint64_t, uint64_t> snapshot_entry, // index, term
-          const msgpack::object& snapshot,
+          uint64_t offset,
+          const std::string& chunk,
+          bool done,
           uint64_t commit_index);
 
     deferred<std::tuple<uint64_t, bool>>
@@ -72,6 +74,17 @@ private:
                  raft::node_id_t candidate,
                  std::tuple<uint64_t, uint64_t> last_entry);
 
+    typedef std::tuple<
+        std::string,
+        uint64_t,
+        raft::node_id_t,
+        std::tuple<uint64_t, uint64_t>,
+        uint64_t
+    > heartbeat_type;
+
+    deferred<std::vector<std::tuple<uint64_t, bool>>>
+    heartbeat(const std::vector<heartbeat_type>& batch);
+
     deferred<command_result<void>>
     insert(const std::string& machine, const node_id_t& node);
 
@@ -47,6 +47,12 @@ struct options_t {
     // Leader will send at most message_size entries in one append message.
     // Also actor will apply at most message_size entries at once.
     unsigned int message_size;
+
+    // Leader will keep at most append_window append requests to a single follower in flight.
+    unsigned int append_window;
+
+    // Snapshots are sent to followers in chunks of at most snapshot_chunk_size bytes.
+    unsigned int snapshot_chunk_size;
 };
 
 }} // namespace cocaine::raft
@@ -22,13 +22,17 @@
 #define COCAINE_RAFT_REMOTE_HPP
 
 #include "cocaine/detail/client.hpp"
+#include "cocaine/detail/raft/heartbeats.hpp"
+#include "cocaine/detail/raft/log_handle.hpp"
 #include "cocaine/idl/raft.hpp"
 #include "cocaine/traits/graph.hpp"
 #include "cocaine/traits/literal.hpp"
+#include "cocaine/traits/raft.hpp"
 
 #include "cocaine/logging.hpp"
 
 #include <algorithm>
+#include <deque>
 
 namespace cocaine { namespace raft {
 
@@ -43,6 +47,7 @@ class remote_node {
     typedef typename actor_type::entry_type entry_type;
     typedef typename actor_type::snapshot_type snapshot_type;
     typedef io::raft_node<entry_type, snapshot_type> protocol;
+    typedef entry_range<log_handle<actor_type>, entry_type> entry_range_type;
 
     // This class handles response from remote node on append request.
     class vote_handler_t {
@@ -97,18 +102,14 @@ class remote_node {
     // This class handles response from remote node on append request.
     class append_handler_t {
     public:
-        append_handler_t(remote_node &remote):
+        append_handler_t(remote_node &remote, uint64_t first_index, uint64_t last_index):
             m_active(true),
             m_remote(remote),
-            m_last_index(0)
+            m_first_index(first_index),
+            m_last_index(last_index),
+            m_sent(remote.m_actor.reactor().native().now())
         { }
 
-        // Set index of last entry replicated with this request.
-        void
-        set_last(uint64_t last_index) {
-            m_last_index = last_index;
-        }
-
         void
         handle(boost::variant<std::error_code, std::tuple<uint64_t, bool>> result) {
             // If the request is outdated, do nothing.
@@ -120,12 +121,10 @@ class remote_node {
             auto client = m_remote.m_client;
             (void)client;
 
-            // Parent node stores pointer to handler of current uncompleted append request.
-            // We should reset this pointer, when the request becomes completed.
-            m_remote.reset_append_state();
+            // Parent node stores pointers to handlers of all uncompleted append requests.
+            // We should remove this one, when the request becomes completed.
+            m_remote.complete_append(this);
 
-            // Do nothing if the request has failed.
-            // The next append request will be sent with the next heartbeat.
             if(boost::get<std::tuple<uint64_t, bool>>(&result)) {
                 const auto &response = boost::get<std::tuple<uint64_t, bool>>(result);
 
@@ -133,7 +132,12 @@ class remote_node {
                     // Stepdown to follower state if we live in old term.
                     m_remote.m_actor.step_down(std::get<0>(response));
                     return;
-                } else if(std::get<1>(response)) {
+                }
+
+                // Even if the entries are discarded, the follower has recognized the leadership.
+                m_remote.acknowledge(m_sent);
+
+                if(std::get<1>(response)) {
                     // Mark entries replicated and update commit index, if remote node returned success.
                     m_remote.m_next_index = std::max(m_last_index + 1, m_remote.m_next_index);
                     if(m_remote.m_match_index < m_last_index) {
@@ -148,11 +152,15 @@ class remote_node {
                         m_remote.m_match_index,
                         m_remote.m_next_index
                     ); */
-                } else if(m_remote.m_next_index > 1) {
+                } else if(m_first_index > 1) {
                     // If follower discarded current request, try to replicate older entries.
-                    m_remote.m_next_index -= std::min<uint64_t>(
+                    // Requests sent after this one rely on the same wrong assumption about
+                    // the follower's log, so they are dropped too.
+                    m_remote.reset_append_state();
+
+                    m_remote.m_next_index = m_first_index - std::min<uint64_t>(
                         m_remote.m_actor.options().message_size,
-                        m_remote.m_next_index - 1
+                        m_first_index - 1
                     );
 
                     /* COCAINE_LOG_DEBUG(
@@ -166,11 +174,18 @@ class remote_node {
                     // The remote node discarded our oldest entries.
                     // There is no sense to retry immediately.
                     // Probably there is no sense to retry at all, but what should the node do then?
+                    m_remote.reset_append_state();
+                    m_remote.m_next_index = m_first_index;
                     return;
                 }
 
                 // Continue replication. If there is no entries to replicate, this call does nothing.
                 m_remote.replicate();
+            } else {
+                // The request has failed, so the entries sent with it and with all the following
+                // requests have to be sent again. It will be done with the next heartbeat.
+                m_remote.reset_append_state();
+                m_remote.m_next_index = std::min(m_first_index, m_remote.m_next_index);
             }
         }
 
@@ -185,17 +200,131 @@ class remote_node {
         bool m_active;
         remote_node &m_remote;
 
-        // Last entry replicated with this request.
-        uint64_t m_last_index;
+        // First and last entries replicated with this request.
+        const uint64_t m_first_index;
+        const uint64_t m_last_index;
+
+        // Time the request was sent at.
+        const ev::tstamp m_sent;
     };
 
-    // This class handles response from remote node on heartbeat.
-    // It's needed because I have to pass some handler to client_t::call.
-    struct heartbeat_handler_t {
+    // This class handles response from remote node on a chunk of the snapshot.
+    class snapshot_handler_t {
+    public:
+        snapshot_handler_t(remote_node &remote, uint64_t snapshot_index, bool done):
+            m_active(true),
+            m_remote(remote),
+            m_snapshot_index(snapshot_index),
+            m_done(done),
+            m_sent(remote.m_actor.reactor().native().now())
+        { }
+
         void
-        operator()(boost::variant<std::error_code, std::tuple<uint64_t, bool>> /* result */) {
-            // Ignore.
+        handle(boost::variant<std::error_code, std::tuple<uint64_t, bool, uint64_t>> result) {
+            // If the request is outdated, do nothing.
+            if(!m_active) {
+                return;
+            }
+
+            // Keep our client alive while the handler works.
+            auto client = m_remote.m_client;
+            (void)client;
+
+            m_remote.reset_snapshot_state();
+
+            // If the request has failed, the transfer will be resumed with the next heartbeat.
+            if(boost::get<std::tuple<uint64_t, bool, uint64_t>>(&result)) {
+                const auto &response = boost::get<std::tuple<uint64_t, bool, uint64_t>>(result);
+
+                if(std::get<0>(response) > m_remote.m_actor.config().current_term()) {
+                    // Stepdown to follower state if we live in old term.
+                    m_remote.m_actor.step_down(std::get<0>(response));
+                    return;
+                }
+
+                m_remote.acknowledge(m_sent);
+
+                if(std::get<1>(response) && m_done) {
+                    // The follower has installed the snapshot.
+                    m_remote.m_snapshot.reset();
+                    m_remote.m_snapshot_offset = 0;
+
+                    m_remote.m_next_index = std::max(m_snapshot_index + 1, m_remote.m_next_index);
+                    if(m_remote.m_match_index < m_snapshot_index) {
+                        m_remote.m_match_index = m_snapshot_index;
+                        m_remote.m_cluster.update_commit_index();
+                    }
+                } else {
+                    // Either the chunk has been accepted or the follower expects another one.
+                    // In both cases the follower knows where to continue from.
+                    m_remote.m_snapshot_offset = std::get<2>(response);
+                }
+
+                m_remote.replicate();
+            }
+        }
+
+        // If the remote node doesn't need result of this request, it makes the handler inactive.
+        void
+        disable() {
+            m_active = false;
         }
+
+    private:
+        bool m_active;
+        remote_node &m_remote;
+
+        // Index of the snapshot being transferred.
+        const uint64_t m_snapshot_index;
+
+        // Whether the request carries the last chunk of the snapshot.
+        const bool m_done;
+
+        // Time the request was sent at.
+        const ev::tstamp m_sent;
+    };
+
+    // This class handles response from remote node on heartbeat. A reply in the current term
+    // confirms that the follower recognizes the leadership, which extends the lease.
+    class heartbeat_handler_t {
+    public:
+        heartbeat_handler_t(remote_node &remote):
+            m_active(true),
+            m_remote(remote),
+            m_sent(remote.m_actor.reactor().native().now())
+        { }
+
+        void
+        handle(boost::variant<std::error_code, std::tuple<uint64_t, bool>> result) {
+            // If the request is outdated, do nothing.
+            if(!m_active) {
+                return;
+            }
+
+            if(boost::get<std::tuple<uint64_t, bool>>(&result)) {
+                const auto &response = boost::get<std::tuple<uint64_t, bool>>(result);
+
+                // An actor which accepts the heartbeat adopts the leader's term before replying.
+                // Stale replies and followers from newer terms don't confirm the leadership, the
+                // latter are handled by the regular append requests.
+                if(std::get<0>(response) == m_remote.m_actor.config().current_term()) {
+                    m_remote.acknowledge(m_sent);
+                }
+            }
+        }
+
+        // If the remote node doesn't need result of this request, it makes the handler inactive.
+        void
+        disable() {
+            m_active = false;
+        }
+
+    private:
+        bool m_active;
+        remote_node &m_remote;
+
+        // Time the heartbeat was sent at.
+        const ev::tstamp m_sent;
     };
 
 public:
@@ -207,13 +336,17 @@ public:
             "raft/" + m_actor.name() + "/remote/" + cocaine::format("%s:%d", id.first, id.second)
         )),
         m_id(id),
-        m_heartbeat_timer(m_actor.reactor().native()),
+        m_snapshot_entry(0, 0),
+        m_snapshot_offset(0),
         m_next_index(std::max<uint64_t>(1, m_actor.log().last_index())),
         m_match_index(0),
+        m_acknowledged(0),
         m_won_term(0),
         m_disconnected(false)
     {
-        m_heartbeat_timer.set<remote_node, &remote_node::heartbeat>(this);
+        if(m_id != m_actor.context().raft().id()) {
+            m_heartbeats = m_actor.context().raft().heartbeats(m_id);
+        }
     }
 
     ~remote_node() {
@@ -241,20 +374,18 @@ public:
 
     // When new entries are added to the log,
     // Raft actor tells this class that it's time to replicate.
+    // Leader doesn't wait for responses to send more entries: up to options().append_window
+    // requests may be in flight, and the next index is advanced as if they were already accepted.
     void
     replicate() {
-        // TODO: Now leader sends one append request at the same time.
-        // Probably it's possible to send requests in pipeline manner.
-        // I should investigate this question.
         if(m_id == m_actor.context().raft().id()) {
             m_match_index = m_actor.log().last_index();
             m_cluster.update_commit_index();
-        } else if(!m_append_state &&
+        } else if(!m_resolver &&
                   m_actor.is_leader() &&
+                  m_append_state.size() < m_actor.options().append_window &&
                   m_actor.log().last_index() >= m_next_index)
         {
-            // Create new append state to mark, that there is active append request.
-            m_append_state = std::make_shared<append_handler_t>(*this);
             ensure_connection(std::bind(&remote_node::replicate_impl, this));
         }
     }
@@ -265,6 +396,25 @@ public:
         return m_match_index;
     }
 
+    // Send time of the latest request acknowledged by the remote node in the current term.
+    // The local node always acknowledges the leadership.
+    ev::tstamp
+    acknowledged() const {
+        if(m_id == m_actor.context().raft().id()) {
+            return m_actor.reactor().native().now();
+        } else {
+            return m_acknowledged;
+        }
+    }
+
+    // Send heartbeat right now to confirm the leadership.
+    void
+    confirm_leadership() {
+        if(m_id != m_actor.context().raft().id() && m_actor.is_leader()) {
+            send_heartbeat();
+        }
+    }
+
     // Index of last entry replicated to the remote node.
     uint64_t
     won_term() const {
@@ -278,19 +428,22 @@ public:
             m_match_index = m_actor.log().last_index();
             m_next_index = m_match_index + 1;
         } else {
-            m_heartbeat_timer.start(0.0, float(m_actor.options().heartbeat_timeout) / 1000.0);
+            m_heartbeat_subscription = m_heartbeats->subscribe(std::bind(&remote_node::heartbeat, this));
             // Now we don't know which entries are replicated to the remote.
             m_match_index = 0;
+            // Acknowledgements from the previous terms don't count.
+            m_acknowledged = 0;
             m_next_index = std::max<uint64_t>(1, m_actor.log().last_index());
+
+            // Don't wait for the next tick of the channel to assert the leadership.
+            heartbeat();
         }
     }
 
     // Stop sending heartbeats.
     void
     finish_leadership() {
-        if(m_heartbeat_timer.is_active()) {
-            m_heartbeat_timer.stop();
-        }
+        m_heartbeat_subscription.reset();
         reset();
     }
 
@@ -302,13 +455,16 @@ public:
     // Reset current state of remote node.
     void
     reset() {
-        // Close connection.
+        // Release the connection. It's shared with other users, so it's up to the pool to close it.
         m_resolver.reset();
+        m_client_subscription.reset();
         m_client.reset();
 
-        // Drop current requests.
+        // Drop current requests. The snapshot transfer will be resumed from the same offset.
         reset_vote_state();
         reset_append_state();
+        reset_snapshot_state();
+        reset_heartbeat_state();
 
         // If connection error has occurred, then we don't know what entries are replicated.
         m_match_index = 0;
@@ -316,12 +472,52 @@ public:
     }
 
 private:
-    // Drop current append request.
+    // Drop all the append requests in flight.
     void
     reset_append_state() {
-        if(m_append_state) {
-            m_append_state->disable();
-            m_append_state.reset();
+        for(auto it = m_append_state.begin(); it != m_append_state.end(); ++it) {
+            (*it)->disable();
+        }
+
+        m_append_state.clear();
+    }
+
+    // Forget the completed append request. Responses usually arrive in order of the requests.
+    void
+    complete_append(append_handler_t* handler) {
+        for(auto it = m_append_state.begin(); it != m_append_state.end(); ++it) {
+            if(it->get() == handler) {
+                m_append_state.erase(it);
+                return;
+            }
+        }
+    }
+
+    // Drop current snapshot request.
+    void
+    reset_snapshot_state() {
+        if(m_snapshot_state) {
+            m_snapshot_state->disable();
+            m_snapshot_state.reset();
+        }
+    }
+
+    // Drop current heartbeat.
+    void
+    reset_heartbeat_state() {
+        if(m_heartbeat_state) {
+            m_heartbeat_state->disable();
+            m_heartbeat_state.reset();
+        }
+    }
+
+    void
+    acknowledge(ev::tstamp sent) {
+        if(sent > m_acknowledged) {
+            m_acknowledged = sent;
+
+            // The lease might have been extended, so some pending reads may be served now.
+            m_actor.process_reads();
         }
     }
 
@@ -364,35 +560,70 @@ private:
             COCAINE_LOG_DEBUG(m_logger,
                               "client isn't connected or the local node is not the leader, "
                               "unable to send append request");
-            m_append_state->handle(std::error_code());
-        } else if(m_next_index <= m_actor.log().snapshot_index()) {
-            // If leader is far behind the leader, send snapshot.
-            send_apply();
-        } else if(m_next_index <= m_actor.log().last_index()) {
-            // If there are some entries to replicate, then send them to the follower.
-            send_append();
+            return;
+        }
+
+        // Fill the window of requests in flight.
+        while(!m_snapshot_state && m_append_state.size() < m_actor.options().append_window) {
+            if(m_next_index <= m_actor.log().snapshot_index()) {
+                // If follower is far behind the leader, send snapshot. The transfer starts when all
+                // the append requests in flight are completed and holds the window until it's done.
+                if(m_append_state.empty()) {
+                    send_snapshot_chunk();
+                }
+
+                break;
+            } else if(m_next_index <= m_actor.log().last_index()) {
+                // If there are some entries to replicate, then send them to the follower.
+                send_append();
+            } else {
+                break;
+            }
         }
     }
 
+    // Sends the next chunk of the snapshot. Only one chunk is in flight at the same time.
     void
-    send_apply() {
-        auto handler = std::bind(&append_handler_t::handle, m_append_state, std::placeholders::_1);
-        auto dispatch = make_proxy<std::tuple<uint64_t, bool>>(handler);
-
+    send_snapshot_chunk() {
         auto snapshot_entry = std::make_tuple(
             m_actor.log().snapshot_index(),
             m_actor.log().snapshot_term()
         );
 
-        m_append_state->set_last(m_actor.log().snapshot_index());
+        // Start the transfer from scratch, if the leader has taken a new snapshot since the last
+        // attempt. Otherwise the transfer is resumed.
+        if(!m_snapshot || m_snapshot_entry != snapshot_entry) {
+            m_snapshot = m_actor.log().packed_snapshot();
+            m_snapshot_entry = snapshot_entry;
+            m_snapshot_offset = 0;
+        }
+
+        const uint64_t offset = std::min<uint64_t>(m_snapshot_offset, m_snapshot->size());
+        const uint64_t size = std::min<uint64_t>(
+            m_actor.options().snapshot_chunk_size,
+            m_snapshot->size() - offset
+        );
+        const bool done = offset + size == m_snapshot->size();
+
+        m_snapshot_state = std::make_shared<snapshot_handler_t>(
+            *this,
+            std::get<0>(snapshot_entry),
+            done
+        );
+
+        auto handler = std::bind(&snapshot_handler_t::handle, m_snapshot_state, std::placeholders::_1);
+        auto dispatch = make_proxy<std::tuple<uint64_t, bool, uint64_t>>(handler);
 
+        // The chunk is packed right from the shared serialized snapshot.
         m_client->call<typename protocol::apply>(
             dispatch,
             m_actor.name(),
             m_actor.config().current_term(),
             m_actor.context().raft().id(),
             snapshot_entry,
-            m_actor.log().snapshot(),
+            offset,
+            io::literal_t { m_snapshot->data() + offset, size },
+            done,
             m_actor.config().commit_index()
         );
 
@@ -400,15 +631,15 @@ private:
         (blackhole::attribute::list({
             {"current_term", m_actor.config().current_term()},
             {"next_index", m_next_index},
-            {"snapshot_index", m_actor.log().snapshot_index()}
+            {"snapshot_index", m_actor.log().snapshot_index()},
+            {"chunk_offset", offset},
+            {"chunk_size", size},
+            {"snapshot_size", m_snapshot->size()}
         }));
     }
 
     void
     send_append() {
-        auto handler = std::bind(&append_handler_t::handle, m_append_state, std::placeholders::_1);
-        auto dispatch = make_proxy<std::tuple<uint64_t, bool>>(handler);
-
         // Term of prev_entry. Probably this logic could be in the log,
         // but I wanted to make log implementation as simple as possible,
         // because user can implement own log.
@@ -427,25 +658,19 @@ private:
             last_index = m_actor.log().last_index();
         }
 
-        // This vector stores entries to be sent.
+        m_append_state.push_back(std::make_shared<append_handler_t>(*this, m_next_index, last_index));
 
-        // TODO: We can send entries without copying.
-        // We just need to implement type_traits to something like boost::Range.
-        std::vector<entry_type> entries;
-
-        for(uint64_t i = m_next_index; i <= last_index; ++i) {
-            entries.push_back(m_actor.log()[i]);
-        }
-
-        m_append_state->set_last(last_index);
+        auto handler = std::bind(&append_handler_t::handle, m_append_state.back(), std::placeholders::_1);
+        auto dispatch = make_proxy<std::tuple<uint64_t, bool>>(handler);
 
+        // Entries are serialized right from the log.
         m_client->call<typename protocol::append>(
             dispatch,
             m_actor.name(),
             m_actor.config().current_term(),
             m_actor.context().raft().id(),
             std::make_tuple(m_next_index - 1, prev_term),
-            entries,
+            entry_range_type(m_actor.log(), m_next_index, last_index),
             m_actor.config().commit_index()
         );
 
@@ -453,46 +678,55 @@ private:
         (blackhole::attribute::list({
             {"current_term", m_actor.config().current_term()},
             {"next_index", m_next_index},
-            {"last_index", m_actor.log().last_index()}
+            {"last_index", m_actor.log().last_index()},
+            {"in_flight", m_append_state.size()}
         }));
+
+        // Assume the entries to be accepted. The next index is rolled back on rejection.
+        m_next_index = last_index + 1;
     }
 
     void
     send_heartbeat() {
-        if(m_client) {
-            COCAINE_LOG_DEBUG(m_logger, "sending heartbeat");
-
-            std::tuple<uint64_t, uint64_t> prev_entry(0, 0);
-
-            // Actually we don't need correct prev_entry to heartbeat,
-            // but the follower will not accept commit index from request with old prev_entry.
-            if(m_next_index - 1 <= m_actor.log().snapshot_index()) {
-                prev_entry = std::make_tuple(m_actor.log().snapshot_index(),
-                                             m_actor.log().snapshot_term());
-            } else if(m_next_index - 1 <= m_actor.log().last_index()) {
-                prev_entry = std::make_tuple(m_next_index - 1,
-                                             m_actor.log()[m_next_index - 1].term());
-            }
-
-            m_client->call<typename protocol::append>(
-                make_proxy<std::tuple<uint64_t, bool>>(heartbeat_handler_t()),
-                m_actor.name(),
-                m_actor.config().current_term(),
-                m_actor.context().raft().id(),
-                prev_entry,
-                std::vector<entry_type>(),
-                m_actor.config().commit_index()
-            );
+        COCAINE_LOG_DEBUG(m_logger, "sending heartbeat");
+
+        std::tuple<uint64_t, uint64_t> prev_entry(0, 0);
+
+        // Actually we don't need correct prev_entry to heartbeat,
+        // but the follower will not accept commit index from request with old prev_entry.
+        if(m_next_index - 1 <= m_actor.log().snapshot_index()) {
+            prev_entry = std::make_tuple(m_actor.log().snapshot_index(),
+                                         m_actor.log().snapshot_term());
+        } else if(m_next_index - 1 <= m_actor.log().last_index()) {
+            prev_entry = std::make_tuple(m_next_index - 1,
+                                         m_actor.log()[m_next_index - 1].term());
         }
+
+        // Only the latest heartbeat is tracked, it's the most useful one for the lease anyway.
+        reset_heartbeat_state();
+        m_heartbeat_state = std::make_shared<heartbeat_handler_t>(*this);
+
+        // The heartbeat is batched with the heartbeats of other state machines led by this node.
+        m_heartbeats->send(
+            m_actor.name(),
+            m_actor.config().current_term(),
+            m_actor.context().raft().id(),
+            prev_entry,
+            m_actor.config().commit_index(),
+            std::bind(&heartbeat_handler_t::handle, m_heartbeat_state, std::placeholders::_1)
+        );
     }
 
     void
-    heartbeat(ev::timer&, int) {
+    heartbeat() {
         if(m_actor.is_leader()) {
-            if(m_append_state || m_next_index > m_actor.log().last_index()) {
-                // If there is nothing to replicate or there is active append request,
-                // just send heartbeat.
-                ensure_connection(std::bind(&remote_node::send_heartbeat, this));
+            if(m_snapshot_state ||
+               m_append_state.size() >= m_actor.options().append_window ||
+               m_next_index > m_actor.log().last_index())
+            {
+                // If there is nothing to replicate, the window of append requests is full or
+                // the snapshot is being transferred, just send heartbeat.
+                send_heartbeat();
             } else {
                 replicate();
             }
@@ -530,7 +764,9 @@ private:
         m_resolver.reset();
 
         m_client = client;
-        m_client->bind(std::bind(&remote_node::on_error, this, std::placeholders::_1));
+        m_client_subscription = m_client->subscribe(
+            std::bind(&remote_node::on_error, this, std::placeholders::_1)
+        );
 
         m_disconnected = false;
 
@@ -579,22 +815,42 @@ private:
 
     std::shared_ptr<client_t> m_client;
 
+    // Connection error handler, active while this pointer is alive.
+    std::shared_ptr<client_t::error_handler_t> m_client_subscription;
+
     std::shared_ptr<service_resolver_t> m_resolver;
 
-    ev::timer m_heartbeat_timer;
+    // Heartbeat channel to the remote node shared by all the local state machines.
+    std::shared_ptr<heartbeat_channel_t> m_heartbeats;
 
-    // State of current append request.
-    // When there is no active request, this pointer equals nullptr.
-    std::shared_ptr<append_handler_t> m_append_state;
+    // Ticks of the heartbeat channel, active while this node is the leader.
+    std::shared_ptr<heartbeat_channel_t::tick_handler_t> m_heartbeat_subscription;
+
+    // States of the append requests in flight, in order they were sent.
+    std::deque<std::shared_ptr<append_handler_t>> m_append_state;
 
     std::shared_ptr<vote_handler_t> m_vote_state;
 
+    std::shared_ptr<heartbeat_handler_t> m_heartbeat_state;
+
+    // State of the request with a chunk of the snapshot in flight.
+    std::shared_ptr<snapshot_handler_t> m_snapshot_state;
+
+    // The snapshot being transferred to the follower, its index and term and the offset to continue
+    // from. They survive reconnects, so that the transfer doesn't start from scratch.
+    std::shared_ptr<const std::string> m_snapshot;
+    std::tuple<uint64_t, uint64_t> m_snapshot_entry;
+    uint64_t m_snapshot_offset;
+
     // The next log entry to send to the follower.
     uint64_t m_next_index;
 
     // The last entry replicated to the follower.
     uint64_t m_match_index;
 
+    // Send time of the latest request, which the follower has responded to in the current term.
+    ev::tstamp m_acknowledged;
+
     // The last term, in which the node received vote from the remote.
     uint64_t m_won_term;
 
@@ -30,6 +30,8 @@
 
 namespace cocaine { namespace raft {
 
+class heartbeat_channel_t;
+
 // This class stores Raft actors, which replicate named state machines.
 // Raft service uses this class to deliver messages from other nodes to actors.
 // Core uses it to setup new state machines.
@@ -77,6 +79,10 @@ public:
     void
     activate();
 
+    // Channel to batch heartbeats of all the local leaders to the remote node.
+    std::shared_ptr<heartbeat_channel_t>
+    heartbeats(const node_id_t& node);
+
 private:
     void
     set_options(const options_t& value) {
@@ -90,6 +96,17 @@ private:
     >>
     create_cluster(const std::string& name, Machine&& machine, Config&& config);
 
+    typedef std::map<std::string, std::shared_ptr<actor_concept_t>> actors_type;
+
+    // Creates the actor and registers it under the name, which must be vacant. Must be called with
+    // the actors locked.
+    template<class Machine, class Config>
+    std::shared_ptr<actor<
+        typename std::decay<Machine>::type,
+        typename std::decay<Config>::type
+    >>
+    emplace(actors_type& actors, const std::string& name, Machine&& machine, Config&& config);
+
 private:
     context_t& m_context;
 
@@ -99,10 +116,15 @@ private:
 
     options_t m_options;
 
-    synchronized<std::map<std::string, std::shared_ptr<actor_concept_t>>> m_actors;
+    synchronized<actors_type> m_actors;
 
     synchronized<configs_type> m_configs;
 
+    // NOTE: The channels are owned by the remote nodes of the local state machines, so that the
+    // channels to the nodes which have left all the clusters are destroyed along with the last of
+    // them. The expired entries are swept when a new channel is created.
+    synchronized<std::map<node_id_t, std::weak_ptr<heartbeat_channel_t>>> m_heartbeats;
+
     std::atomic<bool> m_active;
 };
 
@@ -118,26 +140,21 @@ std::shared_ptr<actor<
     typename std::decay<Config>::type
 >>
 repository_t::insert(const std::string& name, Machine&& machine, Config&& config) {
+    typedef actor<typename std::decay<Machine>::type, typename std::decay<Config>::type> actor_type;
+
     auto actors = m_actors.synchronize();
 
-    typedef typename std::decay<Machine>::type machine_type;
-    typedef typename std::decay<Config>::type config_type;
-    typedef actor<machine_type, config_type> actor_type;
+    if(actors->count(name)) {
+        return std::shared_ptr<actor_type>();
+    }
 
-    auto actor = std::make_shared<actor_type>(m_context,
-                                              *m_reactor,
-                                              name,
-                                              std::forward<Machine>(machine),
-                                              std::forward<Config>(config));
+    auto actor = emplace(*actors, name, std::forward<Machine>(machine), std::forward<Config>(config));
 
-    if(actors->insert(std::make_pair(name, actor)).second) {
-        if(m_active) {
-            m_reactor->post(std::bind(&actor_type::join_cluster, actor));
-        }
-        return actor;
-    } else {
-        return std::shared_ptr<actor_type>();
+    if(m_active) {
+        m_reactor->post(std::bind(&actor_type::join_cluster, actor));
     }
+
+    return actor;
 }
 
 template<class Machine>
@@ -147,10 +164,34 @@ std::shared_ptr<actor<
 >>
 repository_t::insert(const std::string& name, Machine&& machine) {
     typedef cocaine::raft::configuration<typename std::decay<Machine>::type> config_type;
+    typedef actor<typename std::decay<Machine>::type, config_type> actor_type;
+
+    const cluster_config_t cluster = {std::set<node_id_t>(), boost::none};
+
+    // NOTE: The actors stay locked until the actor is registered, because opening the journal
+    // recovers and rewrites it, so it must never be opened twice for the same state machine.
+    auto actors = m_actors.synchronize();
+
+    if(actors->count(name)) {
+        return std::shared_ptr<actor_type>();
+    }
+
+    std::shared_ptr<actor_type> actor;
 
-    return insert(name,
-                  std::forward<Machine>(machine),
-                  config_type(cluster_config_t {std::set<node_id_t>(), boost::none}));
+    if(m_context.config.raft_journal) {
+        // Every state machine gets its own journal, named after the machine.
+        auto journal = std::make_shared<journal_t>(*m_context.config.raft_journal + "/" + name);
+
+        actor = emplace(*actors, name, std::forward<Machine>(machine), config_type(cluster, journal));
+    } else {
+        actor = emplace(*actors, name, std::forward<Machine>(machine), config_type(cluster));
+    }
+
+    if(m_active) {
+        m_reactor->post(std::bind(&actor_type::join_cluster, actor));
+    }
+
+    return actor;
 }
 
 template<class Machine, class Config>
@@ -159,11 +200,30 @@ std::shared_ptr<actor<
     typename std::decay<Config>::type
 >>
 repository_t::create_cluster(const std::string& name, Machine&& machine, Config&& config) {
+    typedef actor<typename std::decay<Machine>::type, typename std::decay<Config>::type> actor_type;
+
     auto actors = m_actors.synchronize();
 
-    typedef typename std::decay<Machine>::type machine_type;
-    typedef typename std::decay<Config>::type config_type;
-    typedef actor<machine_type, config_type> actor_type;
+    if(actors->count(name)) {
+        return std::shared_ptr<actor_type>();
+    }
+
+    auto actor = emplace(*actors, name, std::forward<Machine>(machine), std::forward<Config>(config));
+
+    if(m_active) {
+        m_reactor->post(std::bind(&actor_type::create_cluster, actor));
+    }
+
+    return actor;
+}
+
+template<class Machine, class Config>
+std::shared_ptr<actor<
+    typename std::decay<Machine>::type,
+    typename std::decay<Config>::type
+>>
+repository_t::emplace(actors_type& actors, const std::string& name, Machine&& machine, Config&& config) {
+    typedef actor<typename std::decay<Machine>::type, typename std::decay<Config>::type> actor_type;
 
     auto actor = std::make_shared<actor_type>(m_context,
                                               *m_reactor,
@@ -171,14 +231,9 @@ repository_t::create_cluster(const std::string& name, Machine&& machine, Config&
                                               std::forward<Machine>(machine),
                                               std::forward<Config>(config));
 
-    if(actors->insert(std::make_pair(name, actor)).second) {
-        if(m_active) {
-            m_reactor->post(std::bind(&actor_type::create_cluster, actor));
-        }
-        return actor;
-    } else {
-        return std::shared_ptr<actor_type>();
-    }
+    actors.insert(std::make_pair(name, actor));
+
+    return actor;
 }
 
 }} // namespace cocaine::raft
@@ -0,0 +1,386 @@
+/*
+    Copyright (c) 2011-2014 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2014 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_SCHEMA_HPP
+#define COCAINE_SCHEMA_HPP
+
+#include "cocaine/common.hpp"
+#include "cocaine/dynamic.hpp"
+
+#include "cocaine/traits/dynamic.hpp"
+
+#include <cstring>
+#include <functional>
+
+namespace cocaine {
+
+// Schemas map the struct fields to the object keys, so that structs are decoded straight from the
+// msgpack objects, e.g. the ones fetched from the storage, with no dynamic_t tree built in between.
+// The same schema also decodes structs from dynamic objects, like the ones from the config.
+//
+// To describe a struct, specialize schema_traits for it, returning the schema built once:
+//
+// template<>
+// struct schema_traits<settings_t> {
+//     static const bool enable = true;
+//
+//     static
+//     const schema_t<settings_t>&
+//     schema();
+// };
+//
+// Then such structs can be used with the storages, dynamic_t::to<T>() and nested into other schemas.
+
+template<class T, class = void>
+struct schema_traits {
+    static const bool enable = false;
+};
+
+namespace aux {
+
+// Field value codecs. Numbers are converted between the numeric types freely, like dynamic_t does,
+// so that stored objects are decoded the same way they were before.
+
+template<class T, class = void>
+struct schema_value {
+    static inline
+    void
+    unpack(const msgpack::object& source, T& target) {
+        io::type_traits<T>::unpack(source, target);
+    }
+
+    static inline
+    void
+    convert(const dynamic_t& source, T& target) {
+        target = source.to<T>();
+    }
+};
+
+template<class T>
+struct schema_value<
+    T,
+    typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type
+>
+{
+    static inline
+    void
+    unpack(const msgpack::object& source, T& target) {
+        switch(source.type) {
+        case msgpack::type::POSITIVE_INTEGER:
+            target = static_cast<T>(source.via.u64);
+            break;
+        case msgpack::type::NEGATIVE_INTEGER:
+            target = static_cast<T>(source.via.i64);
+            break;
+        case msgpack::type::DOUBLE:
+            target = static_cast<T>(source.via.dec);
+            break;
+        default:
+            throw msgpack::type_error();
+        }
+    }
+
+    static inline
+    void
+    convert(const dynamic_t& source, T& target) {
+        target = source.to<T>();
+    }
+};
+
+template<class Struct, class T>
+struct field_codec {
+    field_codec(const std::string& key, T Struct::*member):
+        m_key(key),
+        m_member(member)
+    { }
+
+    void
+    operator()(const msgpack::object& source, Struct& target) const {
+        schema_value<T>::unpack(source, target.*m_member);
+    }
+
+    void
+    operator()(const dynamic_t& source, Struct& target) const {
+        schema_value<T>::convert(source, target.*m_member);
+    }
+
+    void
+    operator()(const Struct& source, dynamic_t::object_t& target) const {
+        target.emplace(m_key, dynamic_t(source.*m_member));
+    }
+
+private:
+    const std::string m_key;
+    T Struct::*m_member;
+};
+
+template<class Struct, class T>
+struct default_value {
+    void
+    operator()(Struct& target) const {
+        target.*member = value;
+    }
+
+    T Struct::*member;
+    T value;
+};
+
+template<class Struct, class T>
+struct derived_value {
+    void
+    operator()(Struct& target) const {
+        target.*member = derive(static_cast<const Struct&>(target));
+    }
+
+    T Struct::*member;
+    T (*derive)(const Struct&);
+};
+
+} // namespace aux
+
+template<class Struct>
+class schema_t {
+    struct field_t {
+        std::string key;
+
+        std::function<void(const msgpack::object&, Struct&)> unpack;
+        std::function<void(const dynamic_t&, Struct&)> convert;
+        std::function<void(const Struct&, dynamic_t::object_t&)> encode;
+
+        // Fills the field in when the key is missing. Empty for the required fields.
+        std::function<void(Struct&)> fallback;
+    };
+
+public:
+    typedef void (*validator_type)(const Struct&);
+
+    template<class T>
+    schema_t&
+    required(const std::string& key, T Struct::*member) {
+        return field(key, member, std::function<void(Struct&)>());
+    }
+
+    template<class T>
+    schema_t&
+    optional(const std::string& key, T Struct::*member, const typename std::common_type<T>::type& value) {
+        return field(key, member, aux::default_value<Struct, T> { member, value });
+    }
+
+    // The default value depends on the other fields, which are filled in by this time as long as
+    // they are described earlier in the schema.
+    template<class T>
+    schema_t&
+    derived(const std::string& key, T Struct::*member, T (*derive)(const Struct&)) {
+        return field(key, member, aux::derived_value<Struct, T> { member, derive });
+    }
+
+    // Validators are called once the struct is fully decoded and are expected to throw.
+    schema_t&
+    validate(validator_type validator) {
+        m_validators.push_back(validator);
+        return *this;
+    }
+
+    void
+    unpack(const msgpack::object& source, Struct& target) const;
+
+    void
+    convert(const dynamic_t& source, Struct& target) const;
+
+    dynamic_t
+    encode(const Struct& source) const;
+
+private:
+    template<class T>
+    schema_t&
+    field(const std::string& key, T Struct::*member, const std::function<void(Struct&)>& fallback) {
+        aux::field_codec<Struct, T> codec(key, member);
+
+        field_t field = { key, codec, codec, codec, fallback };
+
+        m_fields.push_back(field);
+
+        return *this;
+    }
+
+    void
+    complete(const std::vector<bool>& found, Struct& target) const;
+
+private:
+    std::vector<field_t> m_fields;
+    std::vector<validator_type> m_validators;
+};
+
+template<class Struct>
+void
+schema_t<Struct>::unpack(const msgpack::object& source, Struct& target) const {
+    if(source.type != msgpack::type::MAP) {
+        throw msgpack::type_error();
+    }
+
+    std::vector<bool> found(m_fields.size(), false);
+
+    const msgpack::object_kv *it = source.via.map.ptr,
+                             *const end = it + source.via.map.size;
+
+    for(; it != end; ++it) {
+        if(it->key.type != msgpack::type::RAW) {
+            throw msgpack::type_error();
+        }
+
+        const msgpack::object_raw& key = it->key.via.raw;
+
+        // Schemas are small, so a linear scan over the raw keys is faster than any lookup which
+        // would require to copy the keys into strings first. Unknown keys are skipped.
+        for(size_t i = 0; i < m_fields.size(); ++i) {
+            const std::string& name = m_fields[i].key;
+
+            if(name.size() == key.size && std::memcmp(name.data(), key.ptr, key.size) == 0) {
+                m_fields[i].unpack(it->val, target);
+                found[i] = true;
+                break;
+            }
+        }
+    }
+
+    complete(found, target);
+}
+
+template<class Struct>
+void
+schema_t<Struct>::convert(const dynamic_t& source, Struct& target) const {
+    const dynamic_t::object_t& object = source.as_object();
+
+    std::vector<bool> found(m_fields.size(), false);
+
+    for(size_t i = 0; i < m_fields.size(); ++i) {
+        auto it = object.find(m_fields[i].key);
+
+        if(it != object.end()) {
+            m_fields[i].convert(it->second, target);
+            found[i] = true;
+        }
+    }
+
+    complete(found, target);
+}
+
+template<class Struct>
+dynamic_t
+schema_t<Struct>::encode(const Struct& source) const {
+    dynamic_t::object_t object;
+
+    object.reserve(m_fields.size());
+
+    for(auto it = m_fields.begin(); it != m_fields.end(); ++it) {
+        it->encode(source, object);
+    }
+
+    return object;
+}
+
+template<class Struct>
+void
+schema_t<Struct>::complete(const std::vector<bool>& found, Struct& target) const {
+    for(size_t i = 0; i < m_fields.size(); ++i) {
+        if(found[i]) {
+            continue;
+        }
+
+        if(!m_fields[i].fallback) {
+            throw cocaine::error_t("the '%s' field is missing", m_fields[i].key);
+        }
+
+        m_fields[i].fallback(target);
+    }
+
+    for(auto it = m_validators.begin(); it != m_validators.end(); ++it) {
+        (*it)(target);
+    }
+}
+
+template<class T>
+struct dynamic_constructor<
+    T,
+    typename std::enable_if<schema_traits<T>::enable>::type
+>
+{
+    static const bool enable = true;
+
+    static inline
+    void
+    convert(const T& from, dynamic_t::value_t& to) {
+        dynamic_constructor<dynamic_t::object_t>::convert(
+            std::move(schema_traits<T>::schema().encode(from).as_object()),
+            to
+        );
+    }
+};
+
+template<class T>
+struct dynamic_converter<
+    T,
+    typename std::enable_if<schema_traits<T>::enable>::type
+>
+{
+    typedef T result_type;
+
+    static inline
+    result_type
+    convert(const dynamic_t& from) {
+        result_type result;
+        schema_traits<T>::schema().convert(from, result);
+        return result;
+    }
+
+    static inline
+    bool
+    convertible(const dynamic_t& from) {
+        return from.is_object();
+    }
+};
+
+namespace io {
+
+template<class T>
+struct type_traits<
+    T,
+    typename std::enable_if<schema_traits<T>::enable>::type
+>
+{
+    template<class Stream>
+    static inline
+    void
+    pack(msgpack::packer<Stream>& target, const T& source) {
+        type_traits<dynamic_t>::pack(target, schema_traits<T>::schema().encode(source));
+    }
+
+    static inline
+    void
+    unpack(const msgpack::object& source, T& target) {
+        schema_traits<T>::schema().unpack(source, target);
+    }
+};
+
+} // namespace io
+
+} // namespace cocaine
+
+#endif
@@ -60,6 +60,9 @@ private:
     deferred<raft::command_result<bool>>
     on_cas(int expected, int desired);
 
+    deferred<raft::command_result<int>>
+    on_get();
+
 private:
     const std::unique_ptr<logging::log_t> m_log;
 
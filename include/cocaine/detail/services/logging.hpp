@@ -27,20 +27,102 @@
 
 #include "cocaine/rpc/dispatch.hpp"
 
+#include "cocaine/locked_ptr.hpp"
+
+#include <chrono>
+
 namespace cocaine { namespace service {
 
 class logging_t:
     public api::service_t,
     public dispatch<io::log_tag>
 {
+#if defined(__clang__) || defined(HAVE_GCC47)
+    typedef std::chrono::steady_clock clock_type;
+#else
+    typedef std::chrono::monotonic_clock clock_type;
+#endif
+
+    // Token bucket of a single message source.
+    struct bucket_t {
+        double tokens;
+        clock_type::time_point updated;
+
+        // Messages dropped since the last report.
+        uint64_t dropped;
+    };
+
+    typedef std::tuple<
+        logging::priorities,
+        std::string,
+        std::string,
+        blackhole::log::attributes_t
+    > record_type;
+
     std::unique_ptr<logging::log_context_t> m_logger;
 
+    // Either the own backend or the core logger.
+    logging::log_context_t* m_backend;
+
+    // Messages per second allowed for every source, zero means no limit, and the burst size.
+    const double m_rate_limit;
+    const double m_rate_burst;
+
+    synchronized<std::map<std::string, bucket_t>> m_buckets;
+
+    // When the idle buckets were evicted last time. Guarded by the same lock as the buckets.
+    clock_type::time_point m_swept;
+
+    struct subscription_t;
+
+    // Clients subscribed to the verbosity changes.
+    std::shared_ptr<subscription_t> m_subscription;
+
 public:
     logging_t(context_t& context, io::reactor_t& reactor, const std::string& name, const dynamic_t& args);
 
     virtual
     auto
     prototype() -> io::basic_dispatch_t&;
+
+private:
+    void
+    emit(logging::priorities level,
+         const std::string& source,
+         const std::string& message,
+         const blackhole::log::attributes_t& attributes);
+
+    void
+    emit_batch(const std::vector<record_type>& batch);
+
+    void
+    set_verbosity(logging::priorities value);
+
+    // Checks the message against the rate limit of its source.
+    bool
+    admit(const std::string& source);
+
+    // Same for a batch of messages, under a single buckets lock. Returns the admission flags in the
+    // order of the sources.
+    std::vector<bool>
+    admit(const std::vector<const std::string*>& sources);
+
+    // Takes a token from the bucket of the specified source. Must be called under the buckets lock.
+    // Appends the unreported drops of the source to the list, once it's admitted again.
+    bool
+    consume(std::map<std::string, bucket_t>& buckets,
+            const std::string& source,
+            clock_type::time_point now,
+            std::vector<std::pair<std::string, uint64_t>>& dropped);
+
+    // Evicts the buckets which have been refilled completely, so that the sources which are gone
+    // don't pile up. Must be called under the buckets lock. Returns the unreported drops of the
+    // evicted buckets, to be reported once the lock is released.
+    std::vector<std::pair<std::string, uint64_t>>
+    sweep(std::map<std::string, bucket_t>& buckets, clock_type::time_point now);
+
+    void
+    report(const std::string& source, uint64_t dropped);
 };
 
 }} // namespace cocaine::service
@@ -24,6 +24,7 @@
 #include "cocaine/api/service.hpp"
 #include "cocaine/api/storage.hpp"
 
+#include "cocaine/detail/atomic.hpp"
 #include "cocaine/detail/services/node/forwards.hpp"
 
 #include "cocaine/idl/node.hpp"
@@ -32,6 +33,8 @@
 
 #include "cocaine/rpc/dispatch.hpp"
 
+#include <set>
+
 namespace cocaine { namespace service {
 
 class node_t:
@@ -50,6 +53,21 @@ class node_t:
     // Apps.
     synchronized<app_map_t> m_apps;
 
+    // Names of the apps being started right now. Guarded by the same lock as the apps, so that
+    // the name is reserved atomically with checking that the app isn't running yet.
+    std::set<std::string> m_starting;
+
+    // Startup workers. Apps are constructed and started on these threads, so that manifests are
+    // read and archives are spooled for several apps at once.
+    std::vector<std::shared_ptr<io::reactor_t>> m_workers;
+    std::vector<std::unique_ptr<io::chamber_t>> m_chambers;
+
+    // Set on shutdown, so that the startup workers skip the apps which are not started yet.
+    std::atomic<bool> m_cancelled;
+
+    struct startup_t;
+    struct reservation_t;
+
 public:
     node_t(context_t& context, io::reactor_t& reactor, const std::string& name, const dynamic_t& args);
 
@@ -61,7 +79,7 @@ public:
     prototype() -> io::basic_dispatch_t&;
 
 private:
-    dynamic_t
+    deferred<dynamic_t>
     on_start_app(const std::map<std::string, std::string>& runlist);
 
     dynamic_t
@@ -69,6 +87,13 @@ private:
 
     dynamic_t
     on_list() const;
+
+    // Starts the queued apps one by one until there are none left, runs on the startup workers.
+    void
+    drain(const std::shared_ptr<startup_t>& startup);
+
+    std::string
+    start(const std::string& name, const std::string& profile);
 };
 
 }} // namespace cocaine::service
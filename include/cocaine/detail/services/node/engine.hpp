@@ -32,6 +32,7 @@
 #include "cocaine/detail/services/node/queue.hpp"
 
 #include <mutex>
+#include <unordered_map>
 
 #include <boost/mpl/list.hpp>
 
@@ -129,7 +130,9 @@ class engine_t {
 
     backlog_t m_backlog;
 
-    typedef std::map<
+    // NOTE: Slaves are looked up by their IDs on every handshake and by the session tags on every
+    // tagged enqueue, and the pool is never iterated in any particular order.
+    typedef std::unordered_map<
         std::string,
         std::shared_ptr<slave_t>
     > pool_map_t;
@@ -23,16 +23,24 @@
 
 #include "cocaine/common.hpp"
 #include "cocaine/detail/cached.hpp"
+#include "cocaine/detail/schema.hpp"
 
 #include "cocaine/dynamic.hpp"
 
 namespace cocaine { namespace engine {
 
-struct manifest_t:
-    cached<dynamic_t>
-{
+struct manifest_t {
     manifest_t(context_t& context, const std::string& name);
 
+    // Manifests are decoded straight from the stored objects, see the schema below.
+    manifest_t() = default;
+
+    // Whether the manifest has been found in the cache or fetched from the core storage.
+    auto
+    source() const -> sources::values {
+        return m_source;
+    }
+
     // The application name.
     std::string name;
 
@@ -47,8 +55,24 @@ struct manifest_t:
 
     // Disables the publication of this app via the Locator.
     bool local;
+
+private:
+    sources::values m_source;
 };
 
 }} // namespace cocaine::engine
 
+namespace cocaine {
+
+template<>
+struct schema_traits<engine::manifest_t> {
+    static const bool enable = true;
+
+    static
+    const schema_t<engine::manifest_t>&
+    schema();
+};
+
+} // namespace cocaine
+
 #endif
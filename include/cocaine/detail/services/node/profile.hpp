@@ -23,16 +23,18 @@
 
 #include "cocaine/common.hpp"
 #include "cocaine/detail/cached.hpp"
+#include "cocaine/detail/schema.hpp"
 
 #include "cocaine/dynamic.hpp"
 
 namespace cocaine { namespace engine {
 
-struct profile_t:
-    cached<dynamic_t>
-{
+struct profile_t {
     profile_t(context_t& context, const std::string& name);
 
+    // Profiles are decoded straight from the stored objects, see the schema below.
+    profile_t() = default;
+
     // The profile name.
     std::string name;
 
@@ -54,9 +56,34 @@ struct profile_t:
 
     // NOTE: The slave processes are launched in sandboxed environments,
     // called isolates. This one describes the isolate type and arguments.
-    config_t::component_t isolate;
+    struct isolate_t {
+        std::string type;
+        dynamic_t   args;
+    } isolate;
 };
 
 }} // namespace cocaine::engine
 
+namespace cocaine {
+
+template<>
+struct schema_traits<engine::profile_t> {
+    static const bool enable = true;
+
+    static
+    const schema_t<engine::profile_t>&
+    schema();
+};
+
+template<>
+struct schema_traits<engine::profile_t::isolate_t> {
+    static const bool enable = true;
+
+    static
+    const schema_t<engine::profile_t::isolate_t>&
+    schema();
+};
+
+} // namespace cocaine
+
 #endif
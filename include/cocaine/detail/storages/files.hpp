@@ -22,6 +22,7 @@
 #define COCAINE_FILE_STORAGE_HPP
 
 #include "cocaine/api/storage.hpp"
+#include "cocaine/locked_ptr.hpp"
 
 #include <boost/filesystem/path.hpp>
 
@@ -32,11 +33,15 @@ class files_t:
 {
     const std::unique_ptr<logging::log_t> m_log;
 
-    // TODO: Drop this, switch to atomic writes.
-    std::mutex m_mutex;
-
     const boost::filesystem::path m_storage_path;
 
+    struct collection_t;
+
+    // Every collection has its own reader/writer lock and tag index, so that operations on different
+    // collections never contend with each other. Collections are never removed from this map, but
+    // only writes and lookups in the existing collections add them.
+    synchronized<std::map<std::string, std::shared_ptr<collection_t>>> m_collections;
+
 public:
     files_t(context_t& context, const std::string& name, const dynamic_t& args);
 
@@ -58,6 +63,26 @@ public:
     virtual
     std::vector<std::string>
     find(const std::string& collection, const std::vector<std::string>& tags);
+
+    virtual
+    api::blob_t
+    view(const std::string& collection, const std::string& key);
+
+    virtual
+    boost::optional<std::string>
+    version(const std::string& collection, const std::string& key);
+
+private:
+    // Returns the collection state, creating it if it doesn't exist yet.
+    auto
+    lookup(const std::string& collection) -> std::shared_ptr<collection_t>;
+
+    // Returns the collection state if it exists, or an empty pointer otherwise.
+    auto
+    peek(const std::string& collection) const -> std::shared_ptr<collection_t>;
+
+    void
+    index(const std::string& collection, collection_t& state);
 };
 
 }} // namespace cocaine::storage
@@ -371,7 +371,7 @@ struct dynamic_constructor<std::unordered_map<std::string, T>> {
         auto& object = boost::get<detail::dynamic::incomplete_wrapper<dynamic_t::object_t>>(to).get();
 
         for(auto it = from.begin(); it != from.end(); ++it) {
-            object.insert(it->first, it->second);
+            object.insert(dynamic_t::object_t::value_type(it->first, it->second));
         }
     }
 
@@ -383,7 +383,7 @@ struct dynamic_constructor<std::unordered_map<std::string, T>> {
         auto& object = boost::get<detail::dynamic::incomplete_wrapper<dynamic_t::object_t>>(to).get();
 
         for(auto it = from.begin(); it != from.end(); ++it) {
-            object.insert(it->first, std::move(it->second));
+            object.insert(dynamic_t::object_t::value_type(it->first, std::move(it->second)));
         }
     }
 };
@@ -329,12 +329,12 @@ struct dynamic_converter<dynamic_t::object_t> {
 
 template<>
 struct dynamic_converter<std::map<std::string, dynamic_t>> {
-    typedef const std::map<std::string, dynamic_t>& result_type;
+    typedef std::map<std::string, dynamic_t> result_type;
 
     static inline
     result_type
     convert(const dynamic_t& from) {
-        return from.as_object();
+        return result_type(from.as_object().begin(), from.as_object().end());
     }
 
     static inline
@@ -25,52 +25,126 @@
 
 namespace cocaine {
 
-class dynamic_t::object_t :
-    public std::map<std::string, cocaine::dynamic_t>
-{
-    typedef std::map<std::string, cocaine::dynamic_t> base_type;
-
+// Objects are stored as a flat vector of key-value pairs sorted by key, instead of a node-based
+// tree. Configs, manifests and info responses are small, rarely modified once built and mostly
+// iterated over or looked up, so a contiguous layout saves an allocation per key and is way more
+// cache-friendly. The interface mimics std::map, except that inserting or erasing a key invalidates
+// all the iterators and references into the object, like it does for std::vector.
+class dynamic_t::object_t {
 public:
+    typedef std::string key_type;
+    typedef cocaine::dynamic_t mapped_type;
+    typedef std::pair<std::string, cocaine::dynamic_t> value_type;
+
+    typedef std::vector<value_type> container_type;
+
+    typedef container_type::size_type size_type;
+    typedef container_type::iterator iterator;
+    typedef container_type::const_iterator const_iterator;
+
     object_t() = default;
 
     template<class InputIt>
-    object_t(InputIt first, InputIt last):
-        base_type(first, last)
-    { }
+    object_t(InputIt first, InputIt last) {
+        insert(first, last);
+    }
 
     object_t(const object_t& other):
-        base_type(other)
+        m_values(other.m_values)
     { }
 
     object_t(object_t&& other):
-        base_type(std::move(other))
+        m_values(std::move(other.m_values))
     { }
 
-    object_t(std::initializer_list<value_type> list):
-        base_type(list)
-    { }
+    object_t(std::initializer_list<value_type> list) {
+        insert(list.begin(), list.end());
+    }
 
-    object_t(const base_type& other):
-        base_type(other)
-    { }
+    // Conversions from the former std::map based representation.
 
-    object_t(base_type&& other):
-        base_type(std::move(other))
+    object_t(const std::map<std::string, cocaine::dynamic_t>& other):
+        m_values(other.begin(), other.end())
     { }
 
+    object_t(std::map<std::string, cocaine::dynamic_t>&& other);
+
     object_t&
     operator=(const object_t& other) {
-        base_type::operator=(other);
+        m_values = other.m_values;
         return *this;
     }
 
     object_t&
     operator=(object_t&& other) {
-        base_type::operator=(std::move(other));
+        m_values = std::move(other.m_values);
         return *this;
     }
 
-    using base_type::at;
+    // Iterators
+
+    iterator
+    begin() {
+        return m_values.begin();
+    }
+
+    const_iterator
+    begin() const {
+        return m_values.begin();
+    }
+
+    iterator
+    end() {
+        return m_values.end();
+    }
+
+    const_iterator
+    end() const {
+        return m_values.end();
+    }
+
+    // Capacity
+
+    bool
+    empty() const {
+        return m_values.empty();
+    }
+
+    size_type
+    size() const {
+        return m_values.size();
+    }
+
+    void
+    reserve(size_type size) {
+        m_values.reserve(size);
+    }
+
+    // Lookup
+
+    iterator
+    lower_bound(const std::string& key);
+
+    const_iterator
+    lower_bound(const std::string& key) const;
+
+    iterator
+    find(const std::string& key);
+
+    const_iterator
+    find(const std::string& key) const;
+
+    size_type
+    count(const std::string& key) const {
+        return find(key) == end() ? 0 : 1;
+    }
+
+    // Throws std::out_of_range if there's no such key.
+    cocaine::dynamic_t&
+    at(const std::string& key);
+
+    const cocaine::dynamic_t&
+    at(const std::string& key) const;
 
     cocaine::dynamic_t&
     at(const std::string& key, cocaine::dynamic_t& def);
@@ -78,10 +152,68 @@ public:
     const cocaine::dynamic_t&
     at(const std::string& key, const cocaine::dynamic_t& def) const;
 
-    using base_type::operator[];
+    // Inserts a null value if there's no such key.
+    cocaine::dynamic_t&
+    operator[](const std::string& key);
 
     const cocaine::dynamic_t&
     operator[](const std::string& key) const;
+
+    // Modifiers
+
+    std::pair<iterator, bool>
+    insert(const value_type& value);
+
+    std::pair<iterator, bool>
+    insert(value_type&& value);
+
+    template<class InputIt>
+    void
+    insert(InputIt first, InputIt last) {
+        for(; first != last; ++first) {
+            insert(value_type(first->first, first->second));
+        }
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool>
+    emplace(Args&&... args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    size_type
+    erase(const std::string& key);
+
+    iterator
+    erase(iterator position);
+
+    iterator
+    erase(iterator first, iterator last);
+
+    void
+    clear() {
+        m_values.clear();
+    }
+
+    void
+    swap(object_t& other) {
+        m_values.swap(other.m_values);
+    }
+
+    // Comparison
+
+    bool
+    operator==(const object_t& other) const {
+        return m_values == other.m_values;
+    }
+
+    bool
+    operator!=(const object_t& other) const {
+        return m_values != other.m_values;
+    }
+
+private:
+    container_type m_values;
 };
 
 } // namespace cocaine
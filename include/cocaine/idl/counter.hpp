@@ -78,6 +78,18 @@ struct cas {
     typedef stream_of<raft::command_result<bool>>::tag drain_type;
 };
 
+struct get {
+    typedef counter_tag tag;
+
+    static
+    const char*
+    alias() {
+        return "get";
+    }
+
+    typedef stream_of<raft::command_result<int>>::tag drain_type;
+};
+
 }; // struct counter
 
 template<>
@@ -89,7 +101,8 @@ struct protocol<counter_tag> {
     typedef boost::mpl::list<
         counter::inc,
         counter::dec,
-        counter::cas
+        counter::cas,
+        counter::get
     > messages;
 
     typedef counter scope;
@@ -57,6 +57,27 @@ struct emit {
     > tuple_type;
 };
 
+struct emit_batch {
+    typedef log_tag tag;
+
+    static
+    const char*
+    alias() {
+        return "emit_batch";
+    }
+
+    typedef boost::mpl::list<
+     /* Log messages, each with the same fields as the single message in the emit() method, except
+        the attributes are mandatory. Messages are logged in the specified order. */
+        std::vector<std::tuple<
+            logging::priorities,
+            std::string,
+            std::string,
+            blackhole::log::attributes_t
+        >>
+    > tuple_type;
+};
+
 struct verbosity {
     typedef log_tag tag;
 
@@ -87,6 +108,22 @@ struct set_verbosity {
     > tuple_type;
 };
 
+struct subscribe {
+    typedef log_tag tag;
+
+    static
+    const char*
+    alias() {
+        return "subscribe";
+    }
+
+    typedef stream_of<
+     /* The current verbosity level, followed by the new one every time it's changed. Clients are
+        supposed to drop the messages above this level without sending them. */
+        logging::priorities
+    >::tag drain_type;
+};
+
 }; // struct log
 
 template<>
@@ -98,7 +135,9 @@ struct protocol<log_tag> {
     typedef boost::mpl::list<
         log::emit,
         log::verbosity,
-        log::set_verbosity
+        log::set_verbosity,
+        log::emit_batch,
+        log::subscribe
     > messages;
 
     typedef log scope;
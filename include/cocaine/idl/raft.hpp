@@ -68,6 +68,7 @@ struct append {
 
 // Store snapshot of state machine on the follower.
 // When follower is far behind leader, leader firstly sends snapshot to the follower and then new entries.
+// The serialized snapshot is sent as a sequence of chunks, the follower installs it after the last one.
 struct apply {
     typedef raft_node_tag<Entry, Snapshot> tag;
 
@@ -86,8 +87,12 @@ struct apply {
         cocaine::raft::node_id_t,
      /* Index and term of the last log entry participating in the snapshot. */
         std::tuple<uint64_t, uint64_t>,
-     /* Snapshot. */
-        Snapshot,
+     /* Offset of the chunk in the serialized snapshot. */
+        uint64_t,
+     /* Chunk of the serialized snapshot. */
+        std::string,
+     /* Whether it's the last chunk. */
+        bool,
      /* Leader's commit_index. */
         uint64_t
     > tuple_type;
@@ -96,7 +101,9 @@ struct apply {
      /* Term of the follower. */
         uint64_t,
      /* Success. */
-        bool
+        bool,
+     /* Size of the snapshot received by the follower so far. The leader continues from there. */
+        uint64_t
     >::tag drain_type;
 };
 
@@ -170,6 +177,35 @@ struct erase {
     >::tag drain_type;
 };
 
+// Heartbeats of several state machines led by the same node, coalesced into one message.
+// The node service delivers them to the actors as appends without entries.
+struct heartbeat {
+    typedef raft_node_tag<Entry, Snapshot> tag;
+
+    static
+    const char*
+    alias() {
+        return "heartbeat";
+    }
+
+    typedef boost::mpl::list<
+     /* Heartbeats: name of state machine, leader's term, leader's id, index and term of
+        the entry immediately preceding new ones and leader's commit_index. */
+        std::vector<std::tuple<
+            std::string,
+            uint64_t,
+            cocaine::raft::node_id_t,
+            std::tuple<uint64_t, uint64_t>,
+            uint64_t
+        >>
+    > tuple_type;
+
+    typedef stream_of<
+     /* Term of the follower and success for every heartbeat in the same order. */
+        std::vector<std::tuple<uint64_t, bool>>
+    >::tag drain_type;
+};
+
 }; // struct raft_node
 
 template<class Entry, class Snapshot>
@@ -183,7 +219,8 @@ struct protocol<raft_node_tag<Entry, Snapshot>> {
         typename raft_node<Entry, Snapshot>::apply,
         typename raft_node<Entry, Snapshot>::request_vote,
         typename raft_node<Entry, Snapshot>::insert,
-        typename raft_node<Entry, Snapshot>::erase
+        typename raft_node<Entry, Snapshot>::erase,
+        typename raft_node<Entry, Snapshot>::heartbeat
     > messages;
 
     typedef raft_node<Entry, Snapshot> scope;
@@ -23,6 +23,10 @@
 
 #include "cocaine/common.hpp"
 
+#include "cocaine/detail/atomic.hpp"
+
+#include <mutex>
+
 #include <blackhole/keyword.hpp>
 
 DECLARE_KEYWORD(source, std::string)
@@ -50,6 +54,29 @@ DECLARE_KEYWORD(source, std::string)
 
 namespace cocaine { namespace logging {
 
+// Asynchronous logging mode settings.
+struct async_options_t {
+    enum overflow_policy_t {
+        // Drop the records which don't fit into the queue.
+        drop,
+        // Wait for the writer thread to free some space.
+        block,
+        // Drop the records which don't fit, and log only every n-th debug and info record when the
+        // queue is half full.
+        sample
+    };
+
+    // Maximum number of records waiting for the writer thread.
+    size_t limit;
+
+    overflow_policy_t overflow;
+
+    // Every n-th debug and info record is logged in the sampling mode.
+    size_t rate;
+};
+
+class log_queue_t;
+
 struct log_context_t {
     COCAINE_DECLARE_NONCOPYABLE(log_context_t)
 
@@ -57,6 +84,8 @@ struct log_context_t {
     log_context_t(blackhole::synchronized<logger_t>&& logger);
     log_context_t(log_context_t&& other);
 
+   ~log_context_t();
+
     log_context_t&
     operator=(log_context_t&& other);
 
@@ -68,11 +97,36 @@ struct log_context_t {
     void
     set_verbosity(priorities value);
 
+    // Switches the context to the asynchronous mode, in which records are written by a dedicated
+    // thread. The context must not be moved afterwards.
+    void
+    set_async(const async_options_t& options);
+
     blackhole::synchronized<logger_t>&
     logger() {
         return m_logger;
     }
 
+    // Records are filtered here without taking the logger lock. In the asynchronous mode, they are
+    // opened without it as well, so that only the writer thread ever waits for the logger.
+    blackhole::log::record_t
+    open_record(priorities level);
+
+    // Same, but with the message, the source and the attributes filled in.
+    blackhole::log::record_t
+    open_record(priorities level,
+                const std::string& source,
+                const std::string& message,
+                const blackhole::log::attributes_t& attributes);
+
+    void
+    push(blackhole::log::record_t&& record);
+
+    // Pushes the whole batch in a single pass over the writer queue in the asynchronous mode, or
+    // under a single lock acquisition otherwise.
+    void
+    push(std::vector<blackhole::log::record_t>&& records);
+
     void
     emit(priorities level,
          const std::string& source,
@@ -80,8 +134,14 @@ struct log_context_t {
          const blackhole::log::attributes_t& attributes);
 
 private:
-    priorities m_verbosity;
+    std::atomic<priorities> m_verbosity;
     blackhole::synchronized<logger_t> m_logger;
+
+    // Serializes the records pushed in the synchronous mode.
+    std::mutex m_push_mutex;
+
+    // Writer thread queue, only present in the asynchronous mode.
+    std::unique_ptr<log_queue_t> m_queue;
 };
 
 struct log_t {
@@ -92,9 +152,9 @@ struct log_t {
         return m_source;
     }
 
-    blackhole::synchronized<logger_t>&
+    log_context_t&
     logger() {
-        return m_guard.logger();
+        return m_guard;
     }
 
 private:
@@ -23,6 +23,7 @@
 
 #include "cocaine/common.hpp"
 
+#include <mutex>
 #include <typeinfo>
 #include <type_traits>
 
@@ -86,12 +87,27 @@ class repository_t {
 
     category_map_t m_categories;
 
+    typedef std::pair<std::string, std::string> factory_key_t;
+
+    // Plugins known from the manifest cache to provide some components, but not opened yet, keyed
+    // by the component category and type.
+    std::map<factory_key_t, std::string> m_deferred;
+
+    // Components registered by the plugin which is being opened, to record them in its manifest.
+    std::vector<factory_key_t>* m_recording;
+
+    // NOTE: Recursive, because plugins register their components while being opened on demand.
+    std::recursive_mutex m_mutex;
+
 public:
     repository_t();
    ~repository_t();
 
+    // With the manifest cache path specified, only the plugins missing from the cache or modified
+    // since they were cached are opened right away. The others are opened when a component of the
+    // type they provide is requested for the first time.
     void
-    load(const std::string& path);
+    load(const std::string& path, const std::string& cache = std::string());
 
     template<class Category, typename... Args>
     typename category_traits<Category>::ptr_type
@@ -104,25 +120,43 @@ public:
 private:
     void
     open(const std::string& target);
+
+    // Opens the deferred plugin which provides the specified component, if any.
+    std::shared_ptr<factory_concept_t>
+    demand(const std::string& id, const std::string& type);
 };
 
 template<class Category, typename... Args>
 typename category_traits<Category>::ptr_type
 repository_t::get(const std::string& type, Args&&... args) {
     const std::string id = typeid(Category).name();
-    const factory_map_t& factories = m_categories[id];
 
-    factory_map_t::const_iterator it = factories.find(type);
+    std::shared_ptr<factory_concept_t> factory;
+
+    {
+        std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
+        const factory_map_t& factories = m_categories[id];
 
-    if(it == factories.end()) {
+        factory_map_t::const_iterator it = factories.find(type);
+
+        if(it != factories.end()) {
+            factory = it->second;
+        } else {
+            factory = demand(id, type);
+        }
+    }
+
+    if(!factory) {
         throw repository_error_t("the '%s' component is not available", type);
     }
 
     // TEST: Ensure that the plugin is of the actually specified category.
-    BOOST_ASSERT(it->second->id() == typeid(Category));
+    BOOST_ASSERT(factory->id() == typeid(Category));
 
+    // NOTE: Factories might request other components, so they're called without holding the lock.
     return dynamic_cast<typename category_traits<Category>::factory_type&>(
-        *it->second
+        *factory
     ).get(std::forward<Args>(args)...);
 }
 
@@ -143,6 +177,9 @@ repository_t::insert(const std::string& type) {
     );
 
     const std::string id = typeid(category_type).name();
+
+    std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
     factory_map_t& factories = m_categories[id];
 
     if(factories.find(type) != factories.end()) {
@@ -150,6 +187,10 @@ repository_t::insert(const std::string& type) {
     }
 
     factories[type] = std::make_shared<factory_type>();
+
+    if(m_recording) {
+        m_recording->push_back(factory_key_t(id, type));
+    }
 }
 
 struct preconditions_t {
@@ -27,6 +27,43 @@
 
 namespace cocaine { namespace io {
 
+namespace aux {
+
+constexpr
+char
+packed_byte(uint32_t id, size_t size, size_t index) {
+    return static_cast<char>(
+        index == 0    ? (size == 1 ? id : size == 2 ? 0xCC : size == 3 ? 0xCD : 0xCE) :
+        index < size  ? (id >> (8 * (size - 1 - index))) & 0xFF :
+        0
+    );
+}
+
+// Event IDs are known at compile time, so their MessagePack representation is computed once per
+// event, byte for byte the same as the one packer::pack_uint32() would produce for every message.
+template<uint32_t ID>
+struct packed_id {
+    enum constants: size_t {
+        size = ID < 0x80 ? 1 : ID < 0x100 ? 2 : ID < 0x10000 ? 3 : 5
+    };
+
+    static const char data[5];
+};
+
+template<uint32_t ID>
+const char packed_id<ID>::data[5] = {
+    packed_byte(ID, packed_id<ID>::size, 0),
+    packed_byte(ID, packed_id<ID>::size, 1),
+    packed_byte(ID, packed_id<ID>::size, 2),
+    packed_byte(ID, packed_id<ID>::size, 3),
+    packed_byte(ID, packed_id<ID>::size, 4)
+};
+
+// The frame is always a three-element array, so it starts with the same fixarray tag.
+static const char frame_tag = static_cast<char>(0x93);
+
+} // namespace aux
+
 template<class Stream>
 class encoder {
     COCAINE_DECLARE_NONCOPYABLE(encoder)
@@ -81,10 +118,13 @@ public:
 
         std::lock_guard<std::mutex> guard(m_mutex);
 
-        // NOTE: Format is [ChannelID, MessageID, [Args...]].
-        m_packer.pack_array(3);
+        typedef aux::packed_id<traits::id> packed_id;
+
+        // NOTE: Format is [ChannelID, MessageID, [Args...]]. Only the channel ID varies between the
+        // messages of the same event, everything else in the header is written as is.
+        m_buffer.write(&aux::frame_tag, 1);
         m_packer.pack_uint64(stream);
-        m_packer.pack_uint32(traits::id);
+        m_buffer.write(packed_id::data, packed_id::size);
 
         type_traits<typename traits::tuple_type>::pack(m_packer, std::forward<Args>(args)...);
 
@@ -25,6 +25,7 @@
 
 #include "cocaine/traits/tuple.hpp"
 
+#include <limits>
 #include <system_error>
 
 namespace cocaine { namespace io {
@@ -92,6 +93,10 @@ struct message_t {
         {
             throw std::system_error(make_error_code(rpc_errc::frame_format_error));
         }
+
+        if(object.via.array.ptr[1].via.u64 > std::numeric_limits<uint32_t>::max()) {
+            throw std::system_error(make_error_code(rpc_errc::frame_format_error));
+        }
     }
 
     template<class Event, typename... Args>
@@ -108,14 +113,16 @@ struct message_t {
     }
 
 public:
+    // NOTE: The header types and ranges are validated in the constructor, so they're read directly.
+
     uint64_t
     band() const {
-        return m_object.via.array.ptr[0].as<uint64_t>();
+        return m_object.via.array.ptr[0].via.u64;
     }
 
     uint32_t
     id() const {
-        return m_object.via.array.ptr[1].as<uint32_t>();
+        return static_cast<uint32_t>(m_object.via.array.ptr[1].via.u64);
     }
 
     const msgpack::object&
@@ -58,6 +58,10 @@ public:
 
     void
     revoke();
+
+    // Whether the remote peer has disconnected, so that nothing could be sent anymore.
+    bool
+    closed() const;
 };
 
 template<class Event, typename... Args>
@@ -84,6 +88,14 @@ basic_upstream_t::revoke() {
     session->revoke(index);
 }
 
+inline
+bool
+basic_upstream_t::closed() const {
+    std::lock_guard<std::mutex> guard(session->mutex);
+
+    return state != states::active || !session->ptr;
+}
+
 // Forwards for the upstream<T> class
 
 template<class Tag> class message_queue;
@@ -115,6 +127,11 @@ public:
 
         ptr->send<Event>(std::forward<Args>(args)...);
     }
+
+    bool
+    closed() const {
+        return ptr->closed();
+    }
 };
 
 } // namespace cocaine
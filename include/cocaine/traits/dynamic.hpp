@@ -110,6 +110,7 @@ struct type_traits<dynamic_t> {
         switch(source.type) {
         case msgpack::type::MAP: {
             dynamic_t::object_t container;
+            container.reserve(source.via.map.size);
 
             msgpack::object_kv *ptr = source.via.map.ptr,
                                *const end = ptr + source.via.map.size;
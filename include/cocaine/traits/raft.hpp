@@ -66,6 +66,22 @@ struct type_traits<raft::log_entry<StateMachine>> {
     }
 };
 
+template<class Log, class Entry>
+struct type_traits<raft::entry_range<Log, Entry>> {
+    typedef raft::entry_range<Log, Entry> value_type;
+
+    template<class Stream>
+    static inline
+    void
+    pack(msgpack::packer<Stream>& target, const value_type& source) {
+        target.pack_array(source.last >= source.first ? source.last - source.first + 1 : 0);
+
+        for(uint64_t i = source.first; i <= source.last; ++i) {
+            type_traits<Entry>::pack(target, source.log[i]);
+        }
+    }
+};
+
 template<>
 struct type_traits<raft::cluster_config_t> {
     typedef raft::cluster_config_t value_type;
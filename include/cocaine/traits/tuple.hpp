@@ -188,13 +188,12 @@ public:
             #pragma GCC diagnostic pop
         #endif
 
-        std::vector<msgpack::object> objects(
-            source.via.array.ptr,
-            source.via.array.ptr + source.via.array.size
-        );
+        const msgpack::object *begin = source.via.array.ptr,
+                              *const end = begin + source.via.array.size;
 
-        // Recursively unpack every tuple element while validating the types.
-        unpack_sequence<typename boost::mpl::begin<T>::type>(objects.begin(), objects.end(), targets...);
+        // Recursively unpack every tuple element while validating the types. The elements are read
+        // in place, the sequence shape has already been validated above.
+        unpack_sequence<typename boost::mpl::begin<T>::type>(begin, end, targets...);
     }
 
     template<typename... Args>
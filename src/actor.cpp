@@ -34,19 +34,23 @@
 
 #include "cocaine/rpc/dispatch.hpp"
 
+#include <future>
+
 using namespace cocaine;
 
 actor_t::actor_t(context_t& context, std::shared_ptr<io::reactor_t> reactor, std::unique_ptr<io::basic_dispatch_t> prototype):
     m_context(context),
     m_log(new logging::log_t(context, prototype->name())),
     m_reactor(reactor),
-    m_prototype(std::move(prototype))
+    m_prototype(std::move(prototype)),
+    m_running(false)
 { }
 
 actor_t::actor_t(context_t& context, std::shared_ptr<io::reactor_t> reactor, std::unique_ptr<api::service_t> service):
     m_context(context),
     m_log(new logging::log_t(context, service->prototype().name())),
-    m_reactor(reactor)
+    m_reactor(reactor),
+    m_running(false)
 {
     io::basic_dispatch_t *const prototype = &service->prototype();
 
@@ -62,8 +66,59 @@ actor_t::~actor_t() {
 
 void
 actor_t::run(std::vector<io::tcp::endpoint> endpoints) {
-    BOOST_ASSERT(!m_chamber);
+    BOOST_ASSERT(!m_running);
+
+    m_running = true;
+
+    if(m_context.shared(m_reactor)) {
+        // The shared reactor is already running, so the connectors have to be set up on its thread.
+        execute(std::bind(&actor_t::bind, this, std::cref(endpoints)));
+    } else {
+        bind(endpoints);
+
+        m_chamber = std::make_unique<io::chamber_t>(m_prototype->name(), m_reactor);
+    }
+}
+
+void
+actor_t::terminate() {
+    BOOST_ASSERT(m_running);
+
+    m_running = false;
+
+    if(m_chamber) {
+        m_chamber.reset();
+        m_connectors.clear();
+    } else {
+        execute(std::bind(&actor_t::unbind, this));
+    }
+}
+
+namespace {
 
+void
+complete(const std::function<void()>& function, std::promise<void>& promise) {
+    try {
+        function();
+        promise.set_value();
+    } catch(...) {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+} // namespace
+
+void
+actor_t::execute(const std::function<void()>& function) {
+    std::promise<void> promise;
+
+    m_reactor->post(std::bind(&complete, std::cref(function), std::ref(promise)));
+
+    promise.get_future().get();
+}
+
+void
+actor_t::bind(const std::vector<io::tcp::endpoint>& endpoints) {
     for(auto it = endpoints.begin(); it != endpoints.end(); ++it) {
         m_connectors.emplace_back(
             *m_reactor,
@@ -72,15 +127,10 @@ actor_t::run(std::vector<io::tcp::endpoint> endpoints) {
 
         m_connectors.back().bind(std::bind(&actor_t::on_connect, this, std::placeholders::_1));
     }
-
-    m_chamber = std::make_unique<io::chamber_t>(m_prototype->name(), m_reactor);
 }
 
 void
-actor_t::terminate() {
-    BOOST_ASSERT(m_chamber);
-
-    m_chamber.reset();
+actor_t::unbind() {
     m_connectors.clear();
 }
 
@@ -26,9 +26,11 @@
 #include "cocaine/asio/resolver.hpp"
 
 #include "cocaine/detail/actor.hpp"
+#include "cocaine/detail/chamber.hpp"
 #include "cocaine/detail/engine.hpp"
 #include "cocaine/detail/essentials.hpp"
 #include "cocaine/detail/locator.hpp"
+#include "cocaine/detail/schema.hpp"
 
 #ifdef COCAINE_ALLOW_RAFT
     #include "cocaine/detail/raft/repository.hpp"
@@ -41,6 +43,9 @@
 #include "cocaine/logging.hpp"
 #include "cocaine/memory.hpp"
 
+#include "cocaine/traits/tuple.hpp"
+#include "cocaine/traits/vector.hpp"
+
 #include <cstring>
 
 #include <boost/filesystem/convenience.hpp>
@@ -117,6 +122,7 @@ struct dynamic_reader_t {
     void
     EndObject(size_t size) {
         dynamic_t::object_t object;
+        object.reserve(size);
 
         for(size_t i = 0; i < size; ++i) {
             dynamic_t value = std::move(m_stack.top());
@@ -233,24 +239,48 @@ const uint16_t defaults::locator_port          = 10053;
 const uint16_t defaults::min_port              = 32768;
 const uint16_t defaults::max_port              = 61000;
 
+const uint16_t defaults::gossip_port           = 10054;
+const float defaults::gossip_interval          = 1.0f;
+const float defaults::gossip_suspicion         = 5.0f;
+
 const std::string defaults::logging::timestamp = "%Y-%m-%d %H:%M:%S.%f";
 const std::string defaults::logging::verbosity = "info";
+const unsigned long defaults::logging::queue_limit = 8192L;
+const unsigned long defaults::logging::sample_rate = 10L;
 
 // Config
 
 namespace cocaine {
 
 template<>
-struct dynamic_converter<cocaine::config_t::component_t, void> {
-    typedef cocaine::config_t::component_t result_type;
+struct schema_traits<config_t::component_t> {
+    static const bool enable = true;
 
     static
-    result_type
-    convert(const dynamic_t& from) {
-        return cocaine::config_t::component_t {
-            from.as_object().at("type", "unspecified").as_string(),
-            from.as_object().at("args", dynamic_t::empty_object)
-        };
+    const schema_t<config_t::component_t>&
+    schema() {
+        static const schema_t<config_t::component_t> instance = schema_t<config_t::component_t>()
+            .optional("type", &config_t::component_t::type, "unspecified")
+            .optional("args", &config_t::component_t::args, dynamic_t::empty_object);
+
+        return instance;
+    }
+};
+
+template<>
+struct schema_traits<config_t::gossip_t> {
+    static const bool enable = true;
+
+    static
+    const schema_t<config_t::gossip_t>&
+    schema() {
+        static const schema_t<config_t::gossip_t> instance = schema_t<config_t::gossip_t>()
+            .optional("port", &config_t::gossip_t::port, defaults::gossip_port)
+            .optional("interval", &config_t::gossip_t::interval, defaults::gossip_interval)
+            .optional("suspicion", &config_t::gossip_t::suspicion, defaults::gossip_suspicion)
+            .optional("peers", &config_t::gossip_t::peers, std::vector<std::tuple<std::string, uint16_t>>());
+
+        return instance;
     }
 };
 
@@ -420,9 +450,20 @@ struct dynamic_converter<cocaine::config_t::logging_t, void> {
             config_t::logging_t::logger_t log {
                 logmask(object.at("verbosity", defaults::logging::verbosity).as_string()),
                 object.at("timestamp", defaults::logging::timestamp).as_string(),
-                config::parser_t<dynamic_t, blackhole::log_config_t>::parse(it->first, loggers)
+                config::parser_t<dynamic_t, blackhole::log_config_t>::parse(it->first, loggers),
+                boost::none
             };
 
+            if(object.count("async") == 1) {
+                const auto& async = object["async"].as_object();
+
+                log.async = logging::async_options_t {
+                    async.at("queue-limit", defaults::logging::queue_limit).to<size_t>(),
+                    overflow(async.at("overflow", "drop").as_string()),
+                    async.at("sample-rate", defaults::logging::sample_rate).to<size_t>()
+                };
+            }
+
             component.loggers[it->first] = log;
         }
 
@@ -444,6 +485,18 @@ struct dynamic_converter<cocaine::config_t::logging_t, void> {
             return logging::info;
         }
     }
+
+    static inline
+    logging::async_options_t::overflow_policy_t
+    overflow(const std::string& policy) {
+        if(policy == "block") {
+            return logging::async_options_t::block;
+        } else if(policy == "sample") {
+            return logging::async_options_t::sample;
+        } else {
+            return logging::async_options_t::drop;
+        }
+    }
 };
 
 } // namespace cocaine
@@ -547,6 +600,7 @@ config_t::config_t(const std::string& config_path) {
 
     path.plugins = path_config.at("plugins", defaults::plugins_path).as_string();
     path.runtime = path_config.at("runtime", defaults::runtime_path).as_string();
+    path.manifest = path_config.at("manifest", std::string()).as_string();
 
     const auto runtime_path_status = fs::status(path.runtime);
 
@@ -587,6 +641,8 @@ config_t::config_t(const std::string& config_path) {
     network.endpoint = locator_config.at("endpoint", defaults::endpoint).as_string();
     network.locator  = locator_config.at("port", defaults::locator_port).to<uint16_t>();
 
+    network.actor_pool = locator_config.at("actor-pool", 0U).to<unsigned long>();
+
     // WARNING: Now only arrays of two items are allowed.
     auto ports = locator_config.find("port-range");
 
@@ -607,10 +663,22 @@ config_t::config_t(const std::string& config_path) {
                 network_config["gateway"].as_object().at("args", dynamic_t::empty_object)
             };
         }
+
+        if(network_config.count("gossip") == 1) {
+            network.gossip = network_config["gossip"].to<config_t::gossip_t>();
+        }
+
+        if(network.group && network.gossip) {
+            throw cocaine::error_t("the multicast group and the gossip discovery are mutually exclusive");
+        }
     }
 
 #ifdef COCAINE_ALLOW_RAFT
     create_raft_cluster = false;
+
+    if(path_config.count("raft") == 1) {
+        raft_journal = path_config.at("raft").as_string();
+    }
 #endif
 
     // Component configuration
@@ -638,8 +706,9 @@ context_t::context_t(config_t config, const std::string& logger_name):
     // Load the builtins.
     essentials::initialize(*m_repository);
 
-    // Load the plugins.
-    m_repository->load(config.path.plugins);
+    // Load the plugins. With the manifest cache configured, only the plugins which aren't in the
+    // cache are opened right away.
+    m_repository->load(config.path.plugins, config.path.manifest);
 
     // Register logging frontends.
     auto& repository = blackhole::repository_t::instance();
@@ -682,6 +751,10 @@ context_t::context_t(config_t config, const std::string& logger_name):
         );
 
         m_logger->set_verbosity(logger.verbosity);
+
+        if(logger.async) {
+            m_logger->set_async(*logger.async);
+        }
     } catch (const std::out_of_range&) {
         throw cocaine::error_t("the '%s' logger is not configured", logger_name);
     }
@@ -701,8 +774,9 @@ context_t::context_t(config_t config, std::unique_ptr<logger_t>&& logger):
     // Load the builtins.
     essentials::initialize(*m_repository);
 
-    // Load the plugins.
-    m_repository->load(config.path.plugins);
+    // Load the plugins. With the manifest cache configured, only the plugins which aren't in the
+    // cache are opened right away.
+    m_repository->load(config.path.plugins, config.path.manifest);
 
     // NOTE: The context takes the ownership of the passed logger, so it will
     // become invalid at the calling site after this call.
@@ -800,7 +874,7 @@ context_t::insert(const std::string& name, std::unique_ptr<actor_t>&& service) {
     }
 
     if(m_synchronization) {
-        m_synchronization->announce();
+        m_synchronization->announce(name);
     }
 }
 
@@ -834,7 +908,7 @@ context_t::remove(const std::string& name) -> std::unique_ptr<actor_t> {
     }
 
     if(m_synchronization) {
-        m_synchronization->announce();
+        m_synchronization->announce(name);
     }
 
     return service;
@@ -853,6 +927,20 @@ context_t::attach(const std::shared_ptr<io::socket<io::tcp>>& ptr, const std::sh
     m_pool[ptr->fd() % m_pool.size()]->attach(ptr, dispatch);
 }
 
+auto
+context_t::reactor(const std::string& name) -> std::shared_ptr<reactor_t> {
+    if(m_reactors.empty()) {
+        return std::make_shared<reactor_t>();
+    }
+
+    return m_reactors[std::hash<std::string>()(name) % m_reactors.size()];
+}
+
+bool
+context_t::shared(const std::shared_ptr<reactor_t>& reactor) const {
+    return std::find(m_reactors.begin(), m_reactors.end(), reactor) != m_reactors.end();
+}
+
 void
 context_t::bootstrap() {
     auto blog = std::make_unique<logging::log_t>(*this, "bootstrap");
@@ -876,6 +964,18 @@ context_t::bootstrap() {
         m_pool.emplace_back(std::make_unique<execution_unit_t>(*this, "cocaine/execute"));
     }
 
+    if(config.network.actor_pool) {
+        COCAINE_LOG_INFO(blog, "growing the actor reactor pool to %d reactors", config.network.actor_pool);
+
+        // NOTE: Chambers keep references to the reactor pointers, so the vector must never reallocate.
+        m_reactors.reserve(config.network.actor_pool);
+
+        for(unsigned long i = 0; i < config.network.actor_pool; ++i) {
+            m_reactors.push_back(std::make_shared<reactor_t>());
+            m_chambers.emplace_back(std::make_unique<io::chamber_t>("cocaine/actors", m_reactors.back()));
+        }
+    }
+
     COCAINE_LOG_INFO(blog, "starting %d %s", config.services.size(), config.services.size() == 1 ? "service" : "services");
 
     m_synchronization = std::make_shared<synchronization_t>(*this);
@@ -924,6 +1024,9 @@ context_t::bootstrap() {
         // copying intermediate structures around, for example service lists synchronization.
         locator->on<io::locator::synchronize>(m_synchronization);
 
+        // Service list changes are coalesced on the locator thread.
+        m_synchronization->bind(reactor);
+
         service = std::make_unique<actor_t>(
             *this,
             reactor,
@@ -946,4 +1049,7 @@ context_t::bootstrap() {
     }
 
     m_services->emplace_front("locator", std::move(service));
+
+    // The locator is not inserted as the other services, so announce it explicitly.
+    m_synchronization->announce("locator");
 }
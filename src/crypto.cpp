@@ -25,6 +25,13 @@
 
 using namespace cocaine;
 
+namespace {
+
+// How long the security tokens are cached for.
+const std::chrono::seconds token_ttl(60);
+
+} // namespace
+
 template<hashid HashID>
 crypto<HashID>::crypto(context_t& context, const std::string& service):
     m_log(new logging::log_t(context, "crypto")),
@@ -41,8 +48,55 @@ crypto<HashID>::~crypto() {
 template<hashid HashID>
 std::string
 crypto<HashID>::sign(const std::string& message, const std::string& token_id) const {
+    signer_t signer(this->signer(token_id));
+
+    signer.update(message);
+
+    return signer.digest();
+}
+
+template<hashid HashID>
+typename crypto<HashID>::signer_t
+crypto<HashID>::signer(const std::string& token_id) const {
+    COCAINE_LOG_DEBUG(m_log, "signing a message for service '%s' with token '%s'", m_service, token_id);
+
+    return signer_t(token(token_id));
+}
+
+template<hashid HashID>
+void
+crypto<HashID>::invalidate(const std::string& token_id) {
+    m_tokens->erase(token_id);
+}
+
+template<hashid HashID>
+void
+crypto<HashID>::invalidate() {
+    m_tokens->clear();
+}
+
+template<hashid HashID>
+std::string
+crypto<HashID>::token(const std::string& token_id) const {
+    const auto now = clock_type::now();
+
+    {
+        auto locked = m_tokens.synchronize();
+        auto it = locked->find(token_id);
+
+        if(it != locked->end()) {
+            if(it->second.expires > now) {
+                return it->second.value;
+            }
+
+            locked->erase(it);
+        }
+    }
+
     std::string token;
 
+    // NOTE: The storage is accessed without holding the lock, so concurrent misses of the same token
+    // might fetch it twice, which is harmless.
     try {
         token = m_store->template get<std::string>(m_service, token_id);
     } catch(const storage_error_t& e) {
@@ -50,15 +104,59 @@ crypto<HashID>::sign(const std::string& message, const std::string& token_id) co
         throw cocaine::error_t("the specified token has not been found");
     }
 
-    COCAINE_LOG_DEBUG(m_log, "signing a message for service '%s' with token '%s'", m_service, token_id);
+    const token_t cached = { token, now + token_ttl };
+
+    m_tokens->insert(std::make_pair(token_id, cached));
+
+    return token;
+}
+
+// Signer
+
+template<hashid HashID>
+crypto<HashID>::signer_t::signer_t(const std::string& token):
+    m_thread(mhash_hmac_init(HashID, const_cast<char*>(token.data()), token.size(), mhash_get_hash_pblock(HashID)))
+{
+    if(m_thread == MHASH_FAILED) {
+        throw cocaine::error_t("unable to initialize the message signer");
+    }
+}
+
+template<hashid HashID>
+crypto<HashID>::signer_t::signer_t(signer_t&& other):
+    m_thread(other.m_thread)
+{
+    other.m_thread = MHASH_FAILED;
+}
+
+template<hashid HashID>
+crypto<HashID>::signer_t::~signer_t() {
+    if(m_thread != MHASH_FAILED) {
+        // The digest is discarded, but the HMAC state has to be released properly.
+        digest();
+    }
+}
+
+template<hashid HashID>
+void
+crypto<HashID>::signer_t::update(const char* data, size_t size) {
+    BOOST_ASSERT(m_thread != MHASH_FAILED);
+
+    mhash(m_thread, data, size);
+}
+
+template<hashid HashID>
+std::string
+crypto<HashID>::signer_t::digest() {
+    BOOST_ASSERT(m_thread != MHASH_FAILED);
 
-    MHASH thread = mhash_hmac_init(HashID, const_cast<char*>(token.data()), token.size(), mhash_get_hash_pblock(HashID));
     char* digest = static_cast<char*>(::alloca(mhash_get_block_size(HashID)));
 
-    mhash(thread, message.data(), message.size());
-    mhash_hmac_deinit(thread, digest);
+    mhash_hmac_deinit(m_thread, digest);
+    m_thread = MHASH_FAILED;
 
     return std::string(digest, mhash_get_block_size(HashID));
 }
 
 template class cocaine::crypto<MHASH_MD5>;
+template class cocaine::crypto<MHASH_SHA256>;
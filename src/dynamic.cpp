@@ -20,6 +20,9 @@
 
 #include <cocaine/dynamic/dynamic.hpp>
 
+#include <algorithm>
+#include <stdexcept>
+
 using namespace cocaine;
 
 const dynamic_t dynamic_t::null = dynamic_t::null_t();
@@ -27,6 +30,80 @@ const dynamic_t dynamic_t::empty_string = dynamic_t::string_t();
 const dynamic_t dynamic_t::empty_array = dynamic_t::array_t();
 const dynamic_t dynamic_t::empty_object = dynamic_t::object_t();
 
+namespace {
+
+struct key_less {
+    bool
+    operator()(const dynamic_t::object_t::value_type& value, const std::string& key) const {
+        return value.first < key;
+    }
+};
+
+} // namespace
+
+dynamic_t::object_t::object_t(std::map<std::string, cocaine::dynamic_t>&& other) {
+    m_values.reserve(other.size());
+
+    // The map is already sorted, so the values are just moved in the same order.
+    for(auto it = other.begin(); it != other.end(); ++it) {
+        m_values.push_back(value_type(it->first, std::move(it->second)));
+    }
+}
+
+dynamic_t::object_t::iterator
+dynamic_t::object_t::lower_bound(const std::string& key) {
+    return std::lower_bound(m_values.begin(), m_values.end(), key, key_less());
+}
+
+dynamic_t::object_t::const_iterator
+dynamic_t::object_t::lower_bound(const std::string& key) const {
+    return std::lower_bound(m_values.begin(), m_values.end(), key, key_less());
+}
+
+dynamic_t::object_t::iterator
+dynamic_t::object_t::find(const std::string& key) {
+    auto it = lower_bound(key);
+
+    if(it == end() || it->first != key) {
+        return end();
+    } else {
+        return it;
+    }
+}
+
+dynamic_t::object_t::const_iterator
+dynamic_t::object_t::find(const std::string& key) const {
+    auto it = lower_bound(key);
+
+    if(it == end() || it->first != key) {
+        return end();
+    } else {
+        return it;
+    }
+}
+
+cocaine::dynamic_t&
+dynamic_t::object_t::at(const std::string& key) {
+    auto it = find(key);
+
+    if(it == end()) {
+        throw std::out_of_range(key);
+    } else {
+        return it->second;
+    }
+}
+
+const cocaine::dynamic_t&
+dynamic_t::object_t::at(const std::string& key) const {
+    auto it = find(key);
+
+    if(it == end()) {
+        throw std::out_of_range(key);
+    } else {
+        return it->second;
+    }
+}
+
 cocaine::dynamic_t&
 dynamic_t::object_t::at(const std::string& key, cocaine::dynamic_t& default_) {
     auto it = find(key);
@@ -49,11 +126,67 @@ dynamic_t::object_t::at(const std::string& key, const cocaine::dynamic_t& defaul
     }
 }
 
+cocaine::dynamic_t&
+dynamic_t::object_t::operator[](const std::string& key) {
+    auto it = lower_bound(key);
+
+    if(it == end() || it->first != key) {
+        it = m_values.insert(it, value_type(key, dynamic_t()));
+    }
+
+    return it->second;
+}
+
 const cocaine::dynamic_t&
 dynamic_t::object_t::operator[](const std::string& key) const {
     return at(key);
 }
 
+std::pair<dynamic_t::object_t::iterator, bool>
+dynamic_t::object_t::insert(const value_type& value) {
+    return insert(value_type(value));
+}
+
+std::pair<dynamic_t::object_t::iterator, bool>
+dynamic_t::object_t::insert(value_type&& value) {
+    // Objects are usually built in key order, so check the back first to append in O(1).
+    if(m_values.empty() || m_values.back().first < value.first) {
+        m_values.push_back(std::move(value));
+        return std::make_pair(m_values.end() - 1, true);
+    }
+
+    auto it = lower_bound(value.first);
+
+    if(it != end() && it->first == value.first) {
+        return std::make_pair(it, false);
+    }
+
+    return std::make_pair(m_values.insert(it, std::move(value)), true);
+}
+
+dynamic_t::object_t::size_type
+dynamic_t::object_t::erase(const std::string& key) {
+    auto it = find(key);
+
+    if(it == end()) {
+        return 0;
+    }
+
+    m_values.erase(it);
+
+    return 1;
+}
+
+dynamic_t::object_t::iterator
+dynamic_t::object_t::erase(iterator position) {
+    return m_values.erase(position);
+}
+
+dynamic_t::object_t::iterator
+dynamic_t::object_t::erase(iterator first, iterator last) {
+    return m_values.erase(first, last);
+}
+
 struct move_visitor:
     public boost::static_visitor<>
 {
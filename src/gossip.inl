@@ -0,0 +1,780 @@
+/*
+    Copyright (c) 2011-2014 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2014 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/traits/enum.hpp"
+#include "cocaine/traits/vector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+// SWIM-style membership protocol. Every protocol period each node probes a single member picked in
+// a shuffled round-robin order, asking a few other members to probe it indirectly if it fails to
+// respond in time. Members which fail both probes become suspected, and are declared dead unless
+// they refute the suspicion within the configured timeout. Membership updates are not broadcasted,
+// but piggybacked on the probe messages instead, each update being retransmitted O(log N) times.
+
+namespace gossip {
+
+enum class message_type: int {
+    ping,
+    ack,
+    ping_req
+};
+
+enum class member_state: int {
+    alive,
+    suspect,
+    dead
+};
+
+// Member UUID, hostname, service locator port and gossip port.
+typedef std::tuple<std::string, std::string, uint16_t, uint16_t> member_id_t;
+
+// Member state, its incarnation number and its identity.
+typedef std::tuple<member_state, uint64_t, member_id_t> update_t;
+
+// Message type, sequence number, sender's own state, indirect probe target (only meaningful for
+// ping requests) and piggybacked membership updates.
+typedef std::tuple<message_type, uint64_t, update_t, member_id_t, std::vector<update_t>> packet_t;
+
+// Number of members asked to probe the target when it fails to respond to a direct ping.
+const size_t indirect_probes = 3;
+
+// Every update is piggybacked on up to multiplier * log2(N + 1) messages.
+const unsigned int retransmit_multiplier = 3;
+
+// Maximum number of updates piggybacked on a single message.
+const size_t max_piggyback = 16;
+
+// Maximum number of updates sent to a freshly discovered member to speed up its join.
+const size_t max_sync = 256;
+
+// Maximum UDP datagram payload size.
+const size_t max_datagram = 65507;
+
+// Resolves a hostname on the resolver thread and posts the result back to the gossip reactor. The
+// result is discarded if the gossip has been shut down in the meantime.
+struct resolve_job_t {
+    typedef std::function<
+        void(const std::vector<io::udp::endpoint>&, const std::error_code&)
+    > callback_type;
+
+    void
+    operator()() const {
+        std::vector<io::udp::endpoint> endpoints;
+        std::error_code ec;
+
+        try {
+            endpoints = io::resolver<io::udp>::query(boost::asio::ip::udp::v4(), host, port);
+        } catch(const std::system_error& e) {
+            ec = e.code();
+        }
+
+        reactor.post(std::bind(&resolve_job_t::deliver, lifetime, callback, endpoints, ec));
+    }
+
+    static
+    void
+    deliver(const std::weak_ptr<void>& lifetime, const callback_type& callback,
+            const std::vector<io::udp::endpoint>& endpoints, const std::error_code& ec)
+    {
+        if(!lifetime.expired()) {
+            callback(endpoints, ec);
+        }
+    }
+
+    const std::string host;
+    const uint16_t port;
+
+    io::reactor_t& reactor;
+    const std::weak_ptr<void> lifetime;
+    const callback_type callback;
+};
+
+} // namespace gossip
+
+class locator_t::gossip_t {
+    COCAINE_DECLARE_NONCOPYABLE(gossip_t)
+
+    public:
+        gossip_t(locator_t& impl, const config_t::gossip_t& config);
+
+    private:
+        void
+        on_event(ev::io&, int);
+
+        void
+        on_round(ev::timer&, int);
+
+        void
+        on_probe_timeout(ev::timer&, int);
+
+        void
+        send(gossip::message_type type, uint64_t seq, const io::udp::endpoint& endpoint,
+             const gossip::member_id_t& target = gossip::member_id_t(), bool sync = false);
+
+        void
+        merge(const gossip::update_t& update, const io::udp::endpoint* source);
+
+        void
+        transition(const std::string& uuid, gossip::member_state state, uint64_t incarnation);
+
+        void
+        disseminate(const gossip::update_t& update);
+
+        // Hostnames are resolved on the locator resolver thread, so that slow DNS never stalls the
+        // reactor.
+        void
+        resolve(const std::string& host, uint16_t port, const gossip::resolve_job_t::callback_type& callback);
+
+        void
+        on_seed_resolved(const std::string& host, uint16_t port, const std::vector<io::udp::endpoint>& endpoints,
+                         const std::error_code& ec);
+
+        void
+        on_member_resolved(const gossip::update_t& update, const std::vector<io::udp::endpoint>& endpoints,
+                           const std::error_code& ec);
+
+        void
+        join();
+
+        boost::optional<std::string>
+        next();
+
+        bool
+        is_live(const std::string& uuid) const;
+
+        static
+        remote_id_t
+        remote_id(const gossip::member_id_t& id);
+
+    private:
+        locator_t& impl;
+
+        const config_t::gossip_t& m_config;
+        const gossip::member_id_t m_self;
+
+        // Own incarnation number, incremented to refute suspicions.
+        uint64_t m_incarnation;
+
+        struct member_t {
+            gossip::member_id_t id;
+            gossip::member_state state;
+            uint64_t incarnation;
+            io::udp::endpoint endpoint;
+
+            // Time of the last state transition, used to expire suspicions and forget dead members.
+            ev::tstamp timestamp;
+        };
+
+        // Known cluster members indexed by their UUID.
+        std::map<std::string, member_t> m_members;
+
+        // Probe order: a random permutation of the member list, reshuffled after every full pass.
+        std::vector<std::string> m_order;
+        size_t m_cursor;
+
+        struct rumor_t {
+            gossip::update_t update;
+            unsigned int remaining;
+        };
+
+        // Pending membership updates to piggyback, at most one per member.
+        std::map<std::string, rumor_t> m_rumors;
+
+        struct probe_t {
+            std::string uuid;
+            uint64_t seq;
+            bool acked;
+        };
+
+        // Current protocol period probe.
+        probe_t m_probe;
+
+        // Indirect probes performed on behalf of other members: local sequence number to the
+        // requester endpoint and its sequence number.
+        std::map<uint64_t, std::pair<io::udp::endpoint, uint64_t>> m_relays;
+
+        uint64_t m_sequence;
+
+        // Resolved seed endpoints.
+        std::vector<io::udp::endpoint> m_seeds;
+
+        // Members which have been heard of, but are still being resolved.
+        std::set<std::string> m_resolving;
+
+        // Expires when the gossip is destroyed, so that late resolution results are discarded.
+        std::shared_ptr<void> m_lifetime;
+
+        std::unique_ptr<io::socket<io::udp>> m_socket;
+        std::unique_ptr<ev::io> m_socket_watcher;
+        std::unique_ptr<ev::timer> m_round_timer;
+        std::unique_ptr<ev::timer> m_probe_timer;
+
+        random_generator_t m_generator;
+
+        char m_buffer[gossip::max_datagram];
+};
+
+namespace {
+
+struct random_index_t {
+    random_index_t(random_generator_t& generator_):
+        generator(generator_)
+    { }
+
+    ptrdiff_t
+    operator()(ptrdiff_t size) {
+        uniform_uint distribution(0, size - 1);
+        return distribution(generator);
+    }
+
+private:
+    random_generator_t& generator;
+};
+
+template<class Iterator>
+struct by_remaining {
+    bool
+    operator()(const Iterator& lhs, const Iterator& rhs) const {
+        return lhs->second.remaining > rhs->second.remaining;
+    }
+};
+
+} // namespace
+
+locator_t::gossip_t::gossip_t(locator_t& impl_, const config_t::gossip_t& config):
+    impl(impl_),
+    m_config(config),
+    m_self(
+        impl.m_context.config.network.uuid,
+        impl.m_context.config.network.hostname,
+        impl.m_context.config.network.locator,
+        config.port
+    ),
+    m_incarnation(0),
+    m_cursor(0),
+    m_sequence(0),
+    m_lifetime(std::make_shared<int>(0))
+{
+#if defined(__clang__) || defined(HAVE_GCC46)
+    std::random_device device;
+    m_generator.seed(device());
+#else
+    m_generator.seed(static_cast<unsigned long>(::time(nullptr)));
+#endif
+
+    m_probe.seq   = 0;
+    m_probe.acked = false;
+
+    using namespace boost::asio::ip;
+
+    const io::udp::endpoint bindpoint = { address::from_string("0.0.0.0"), m_config.port };
+
+    m_socket.reset(new io::socket<io::udp>());
+
+    if(::bind(m_socket->fd(), bindpoint.data(), bindpoint.size()) != 0) {
+        throw std::system_error(errno, std::system_category(), "unable to bind a gossip socket");
+    }
+
+    COCAINE_LOG_INFO(impl.m_log, "starting the gossip discovery on '%s'", bindpoint);
+
+    // Seeds join the list as they are resolved, the protocol rounds start without waiting for them.
+    for(auto it = m_config.peers.begin(); it != m_config.peers.end(); ++it) {
+        resolve(std::get<0>(*it), std::get<1>(*it), std::bind(&gossip_t::on_seed_resolved, this,
+            std::get<0>(*it), std::get<1>(*it), _1, _2));
+    }
+
+    if(m_config.peers.empty()) {
+        COCAINE_LOG_WARNING(impl.m_log, "no gossip seeds configured, waiting for other nodes to join");
+    }
+
+    m_socket_watcher.reset(new ev::io(impl.m_reactor.native()));
+    m_socket_watcher->set<gossip_t, &gossip_t::on_event>(this);
+    m_socket_watcher->start(m_socket->fd(), ev::READ);
+
+    m_probe_timer.reset(new ev::timer(impl.m_reactor.native()));
+    m_probe_timer->set<gossip_t, &gossip_t::on_probe_timeout>(this);
+
+    m_round_timer.reset(new ev::timer(impl.m_reactor.native()));
+    m_round_timer->set<gossip_t, &gossip_t::on_round>(this);
+    m_round_timer->start(0.0f, m_config.interval);
+}
+
+void
+locator_t::gossip_t::on_event(ev::io&, int) {
+    io::udp::endpoint source;
+    std::error_code ec;
+
+    const ssize_t size = m_socket->read(m_buffer, sizeof(m_buffer), source, ec);
+
+    if(size <= 0) {
+        if(ec) {
+            COCAINE_LOG_ERROR(impl.m_log, "unable to receive a gossip message - [%d] %s", ec.value(),
+                ec.message());
+        }
+
+        return;
+    }
+
+    gossip::packet_t packet;
+
+    try {
+        msgpack::unpacked unpacked;
+        msgpack::unpack(&unpacked, m_buffer, size);
+
+        unpacked.get() >> packet;
+    } catch(const std::exception& e) {
+        COCAINE_LOG_ERROR(impl.m_log, "unable to decode a gossip message from '%s'", source);
+        return;
+    }
+
+    gossip::message_type type;
+    uint64_t seq;
+    gossip::update_t sender;
+    gossip::member_id_t target;
+    std::vector<gossip::update_t> updates;
+
+    std::tie(type, seq, sender, target, updates) = packet;
+
+    const std::string uuid = std::get<0>(std::get<2>(sender));
+
+    if(uuid == std::get<0>(m_self)) {
+        // Seeds might include this very node.
+        return;
+    }
+
+    const bool fresh = m_members.find(uuid) == m_members.end();
+
+    // The sender is obviously alive, and its address is known exactly.
+    merge(sender, &source);
+
+    for(auto it = updates.begin(); it != updates.end(); ++it) {
+        merge(*it, nullptr);
+    }
+
+    if(is_live(uuid)) {
+        // Re-establish the synchronization session in case it has been lost.
+        impl.link(remote_id(m_members[uuid].id));
+    }
+
+    switch(type) {
+    case gossip::message_type::ping:
+        send(gossip::message_type::ack, seq, source, gossip::member_id_t(), fresh);
+        break;
+
+    case gossip::message_type::ack: {
+        if(seq == m_probe.seq) {
+            m_probe.acked = true;
+        }
+
+        auto relay = m_relays.find(seq);
+
+        if(relay != m_relays.end()) {
+            send(gossip::message_type::ack, relay->second.second, relay->second.first);
+            m_relays.erase(relay);
+        }
+    } break;
+
+    case gossip::message_type::ping_req: {
+        auto member = m_members.find(std::get<0>(target));
+
+        if(member == m_members.end() || !is_live(member->first)) {
+            return;
+        }
+
+        m_relays[++m_sequence] = std::make_pair(source, seq);
+
+        send(gossip::message_type::ping, m_sequence, member->second.endpoint);
+    } break;
+    }
+}
+
+void
+locator_t::gossip_t::on_round(ev::timer&, int) {
+    const ev::tstamp now = impl.m_reactor.native().now();
+
+    if(!m_probe.uuid.empty() && !m_probe.acked && is_live(m_probe.uuid)) {
+        const member_t& member = m_members[m_probe.uuid];
+
+        if(member.state == gossip::member_state::alive) {
+            COCAINE_LOG_WARNING(impl.m_log, "node '%s' has failed to respond, suspecting", m_probe.uuid);
+
+            transition(m_probe.uuid, gossip::member_state::suspect, member.incarnation);
+        }
+    }
+
+    m_probe.uuid.clear();
+    m_probe.acked = false;
+    m_probe_timer->stop();
+
+    // Indirect probes which didn't finish within a single protocol period are of no use anymore.
+    m_relays.clear();
+
+    for(auto it = m_members.begin(); it != m_members.end();) {
+        const member_t& member = it->second;
+
+        if(member.state == gossip::member_state::suspect && now - member.timestamp > m_config.suspicion) {
+            COCAINE_LOG_WARNING(impl.m_log, "node '%s' has failed to refute the suspicion, declaring dead",
+                it->first);
+
+            transition(it->first, gossip::member_state::dead, member.incarnation);
+        }
+
+        if(member.state == gossip::member_state::dead && now - member.timestamp > m_config.suspicion * 10) {
+            // NOTE: Dead members are kept around for a while to reject stale updates about them.
+            m_rumors.erase(it->first);
+            m_members.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    auto target = next();
+
+    if(!target) {
+        return join();
+    }
+
+    m_probe.uuid  = target.get();
+    m_probe.seq   = ++m_sequence;
+    m_probe.acked = false;
+
+    send(gossip::message_type::ping, m_probe.seq, m_members[m_probe.uuid].endpoint);
+
+    m_probe_timer->start(m_config.interval / 2);
+}
+
+void
+locator_t::gossip_t::on_probe_timeout(ev::timer&, int) {
+    if(m_probe.acked || !is_live(m_probe.uuid)) {
+        return;
+    }
+
+    std::vector<std::string> helpers;
+
+    for(auto it = m_members.begin(); it != m_members.end(); ++it) {
+        if(it->first != m_probe.uuid && is_live(it->first)) {
+            helpers.push_back(it->first);
+        }
+    }
+
+    random_index_t generator(m_generator);
+
+    std::random_shuffle(helpers.begin(), helpers.end(), generator);
+
+    if(helpers.size() > gossip::indirect_probes) {
+        helpers.resize(gossip::indirect_probes);
+    }
+
+    const gossip::member_id_t target = m_members[m_probe.uuid].id;
+
+    for(auto it = helpers.begin(); it != helpers.end(); ++it) {
+        send(gossip::message_type::ping_req, m_probe.seq, m_members[*it].endpoint, target);
+    }
+}
+
+void
+locator_t::gossip_t::send(gossip::message_type type, uint64_t seq, const io::udp::endpoint& endpoint,
+                          const gossip::member_id_t& target, bool sync)
+{
+    std::vector<gossip::update_t> updates;
+
+    if(sync) {
+        // The recipient has just joined, so tell it about everyone else right away instead of
+        // waiting for these updates to reach it via the dissemination.
+        for(auto it = m_members.begin(); it != m_members.end() && updates.size() < gossip::max_sync; ++it) {
+            if(is_live(it->first)) {
+                updates.emplace_back(it->second.state, it->second.incarnation, it->second.id);
+            }
+        }
+    } else {
+        typedef std::map<std::string, rumor_t>::iterator rumor_iterator;
+
+        std::vector<rumor_iterator> rumors;
+
+        for(auto it = m_rumors.begin(); it != m_rumors.end(); ++it) {
+            rumors.push_back(it);
+        }
+
+        // Prefer the freshest updates, i.e. the ones with the most retransmissions left.
+        std::sort(rumors.begin(), rumors.end(), by_remaining<rumor_iterator>());
+
+        if(rumors.size() > gossip::max_piggyback) {
+            rumors.resize(gossip::max_piggyback);
+        }
+
+        for(auto it = rumors.begin(); it != rumors.end(); ++it) {
+            updates.push_back((*it)->second.update);
+
+            if(--(*it)->second.remaining == 0) {
+                m_rumors.erase(*it);
+            }
+        }
+    }
+
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    packer << gossip::packet_t(
+        type,
+        seq,
+        gossip::update_t(gossip::member_state::alive, m_incarnation, m_self),
+        target,
+        updates
+    );
+
+    if(buffer.size() > gossip::max_datagram) {
+        COCAINE_LOG_ERROR(impl.m_log, "unable to send a gossip message to '%s' - message is too large",
+            endpoint);
+        return;
+    }
+
+    std::error_code ec;
+
+    if(m_socket->write(buffer.data(), buffer.size(), endpoint, ec) != static_cast<ssize_t>(buffer.size())) {
+        if(ec) {
+            COCAINE_LOG_ERROR(impl.m_log, "unable to send a gossip message to '%s' - [%d] %s", endpoint,
+                ec.value(), ec.message());
+        } else {
+            COCAINE_LOG_ERROR(impl.m_log, "unable to send a gossip message to '%s'", endpoint);
+        }
+    }
+}
+
+void
+locator_t::gossip_t::merge(const gossip::update_t& update, const io::udp::endpoint* source) {
+    gossip::member_state state;
+    uint64_t incarnation;
+    gossip::member_id_t id;
+
+    std::tie(state, incarnation, id) = update;
+
+    const std::string& uuid = std::get<0>(id);
+
+    if(uuid == std::get<0>(m_self)) {
+        if(state != gossip::member_state::alive && incarnation >= m_incarnation) {
+            COCAINE_LOG_INFO(impl.m_log, "refuting the suspicion of this node");
+
+            m_incarnation = incarnation + 1;
+
+            disseminate(gossip::update_t(gossip::member_state::alive, m_incarnation, m_self));
+        }
+
+        return;
+    }
+
+    auto it = m_members.find(uuid);
+
+    if(it == m_members.end()) {
+        if(state == gossip::member_state::dead) {
+            return;
+        }
+
+        if(!source) {
+            // The member will be merged once its hostname is resolved, unless it's being resolved
+            // already. The updates received in the meantime are superseded by the later ones anyway.
+            if(m_resolving.insert(uuid).second) {
+                resolve(std::get<1>(id), std::get<3>(id), std::bind(&gossip_t::on_member_resolved, this,
+                    update, _1, _2));
+            }
+
+            return;
+        }
+
+        const io::udp::endpoint endpoint = *source;
+
+        COCAINE_LOG_INFO(impl.m_log, "node '%s' on '%s:%d' has joined the cluster", uuid, std::get<1>(id),
+            std::get<2>(id));
+
+        member_t member = { id, state, incarnation, endpoint, impl.m_reactor.native().now() };
+
+        m_members.insert(std::make_pair(uuid, member));
+
+        // Probe the newcomer within the current pass, at a random position.
+        random_index_t generator(m_generator);
+
+        m_order.insert(m_order.begin() + m_cursor + generator(m_order.size() - m_cursor + 1), uuid);
+
+        disseminate(update);
+
+        impl.link(remote_id(id));
+
+        return;
+    }
+
+    const member_t& member = it->second;
+
+    switch(state) {
+    case gossip::member_state::alive:
+        if(incarnation <= member.incarnation) {
+            return;
+        }
+
+        break;
+
+    case gossip::member_state::suspect:
+        if(member.state == gossip::member_state::dead
+        || (member.state == gossip::member_state::alive   && incarnation <  member.incarnation)
+        || (member.state == gossip::member_state::suspect && incarnation <= member.incarnation))
+        {
+            return;
+        }
+
+        break;
+
+    case gossip::member_state::dead:
+        if(member.state == gossip::member_state::dead) {
+            return;
+        }
+
+        break;
+    }
+
+    transition(uuid, state, incarnation);
+}
+
+void
+locator_t::gossip_t::transition(const std::string& uuid, gossip::member_state state, uint64_t incarnation) {
+    member_t& member = m_members[uuid];
+
+    const bool revived = member.state == gossip::member_state::dead && state != gossip::member_state::dead;
+
+    member.state       = state;
+    member.incarnation = incarnation;
+    member.timestamp   = impl.m_reactor.native().now();
+
+    disseminate(gossip::update_t(state, incarnation, member.id));
+
+    if(state == gossip::member_state::dead) {
+        COCAINE_LOG_INFO(impl.m_log, "node '%s' has left the cluster", uuid);
+        impl.drop(remote_id(member.id));
+    } else if(revived) {
+        m_order.push_back(uuid);
+        impl.link(remote_id(member.id));
+    }
+}
+
+void
+locator_t::gossip_t::disseminate(const gossip::update_t& update) {
+    const double size = static_cast<double>(m_members.size() + 1);
+
+    rumor_t rumor = {
+        update,
+        gossip::retransmit_multiplier * static_cast<unsigned int>(std::ceil(std::log(size + 1) / std::log(2.0)))
+    };
+
+    // NOTE: Newer updates about a member supersede the older ones.
+    m_rumors[std::get<0>(std::get<2>(update))] = rumor;
+}
+
+void
+locator_t::gossip_t::resolve(const std::string& host, uint16_t port,
+                             const gossip::resolve_job_t::callback_type& callback)
+{
+    gossip::resolve_job_t job = { host, port, impl.m_reactor, m_lifetime, callback };
+
+    impl.m_resolver_reactor->post(job);
+}
+
+void
+locator_t::gossip_t::on_seed_resolved(const std::string& host, uint16_t port,
+                                      const std::vector<io::udp::endpoint>& endpoints,
+                                      const std::error_code& ec)
+{
+    if(ec || endpoints.empty()) {
+        COCAINE_LOG_WARNING(impl.m_log, "unable to resolve seed '%s:%d' - [%d] %s", host, port, ec.value(),
+            ec.message());
+        return;
+    }
+
+    m_seeds.insert(m_seeds.end(), endpoints.begin(), endpoints.end());
+
+    // Say hello right away, instead of waiting for a round without anybody to probe.
+    for(auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+        send(gossip::message_type::ping, ++m_sequence, *it);
+    }
+}
+
+void
+locator_t::gossip_t::on_member_resolved(const gossip::update_t& update,
+                                        const std::vector<io::udp::endpoint>& endpoints,
+                                        const std::error_code& ec)
+{
+    const gossip::member_id_t& id = std::get<2>(update);
+
+    m_resolving.erase(std::get<0>(id));
+
+    if(ec || endpoints.empty()) {
+        COCAINE_LOG_WARNING(impl.m_log, "unable to resolve node '%s' gossip endpoint - [%d] %s",
+            std::get<0>(id), ec.value(), ec.message());
+        return;
+    }
+
+    merge(update, &endpoints.front());
+}
+
+void
+locator_t::gossip_t::join() {
+    for(auto it = m_seeds.begin(); it != m_seeds.end(); ++it) {
+        send(gossip::message_type::ping, ++m_sequence, *it);
+    }
+}
+
+boost::optional<std::string>
+locator_t::gossip_t::next() {
+    for(unsigned int pass = 0; pass < 2; ++pass) {
+        while(m_cursor < m_order.size()) {
+            const std::string& uuid = m_order[m_cursor++];
+
+            if(is_live(uuid)) {
+                return uuid;
+            }
+        }
+
+        // Start a new pass over the current member list in a new random order.
+        m_order.clear();
+        m_cursor = 0;
+
+        for(auto it = m_members.begin(); it != m_members.end(); ++it) {
+            if(is_live(it->first)) {
+                m_order.push_back(it->first);
+            }
+        }
+
+        random_index_t generator(m_generator);
+
+        std::random_shuffle(m_order.begin(), m_order.end(), generator);
+    }
+
+    return boost::none;
+}
+
+bool
+locator_t::gossip_t::is_live(const std::string& uuid) const {
+    auto it = m_members.find(uuid);
+    return it != m_members.end() && it->second.state != gossip::member_state::dead;
+}
+
+auto
+locator_t::gossip_t::remote_id(const gossip::member_id_t& id) -> remote_id_t {
+    return remote_id_t(std::get<0>(id), std::get<1>(id), std::get<2>(id));
+}
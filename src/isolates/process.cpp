@@ -139,7 +139,9 @@ process_t::process_t(context_t& context, const std::string& name, const dynamic_
     m_context(context),
     m_log(new logging::log_t(context, name)),
     m_name(name),
-    m_working_directory(fs::path(args.as_object().at("spool", "/var/spool/cocaine").as_string()) / name)
+    m_working_directory(fs::path(args.as_object().at("spool", "/var/spool/cocaine").as_string()) / name),
+    m_spool_cache(fs::path(args.as_object().at("spool", "/var/spool/cocaine").as_string()) / ".cache"),
+    m_read_only(args.as_object().at("read-only", false).as_bool())
 {
 #ifdef COCAINE_ALLOW_CGROUPS
     int rv = 0;
@@ -36,8 +36,9 @@ archive_error_t::archive_error_t(archive* source):
     std::runtime_error(archive_error_string(source))
 { }
 
-archive_t::archive_t(context_t& context, const std::string& archive):
+archive_t::archive_t(context_t& context, const api::blob_t& blob):
     m_log(new logging::log_t(context, "packaging")),
+    m_blob(blob),
     m_archive(archive_read_new())
 {
 #if ARCHIVE_VERSION_NUMBER < 3000000
@@ -50,15 +51,15 @@ archive_t::archive_t(context_t& context, const std::string& archive):
 
     const int rv = archive_read_open_memory(
         m_archive,
-        const_cast<char*>(archive.data()),
-        archive.size()
+        const_cast<char*>(m_blob.data()),
+        m_blob.size()
     );
 
     if(rv != ARCHIVE_OK) {
         throw archive_error_t(m_archive);
     }
 
-    COCAINE_LOG_INFO(m_log, "compression: %s, size: %llu bytes", type(), archive.size());
+    COCAINE_LOG_INFO(m_log, "compression: %s, size: %llu bytes", type(), m_blob.size());
 }
 
 archive_t::~archive_t() {
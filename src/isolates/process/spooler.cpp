@@ -23,39 +23,345 @@
 #include "cocaine/api/storage.hpp"
 
 #include "cocaine/detail/isolates/archive.hpp"
+#include "cocaine/detail/unique_id.hpp"
 
 #include "cocaine/context.hpp"
 #include "cocaine/logging.hpp"
 
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <set>
+
+#include <boost/filesystem/operations.hpp>
+
+#define PROTOTYPES
+
+#include <mutils/mincludes.h>
+#include <mutils/mhash.h>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+    #include <linux/fs.h>
+#endif
+
 using namespace cocaine;
 using namespace cocaine::isolate;
 
+namespace fs = boost::filesystem;
+
+namespace {
+
+std::string
+digest_of(const api::blob_t& blob) {
+    static const char hex[] = "0123456789abcdef";
+
+    MHASH thread = mhash_init(MHASH_SHA256);
+
+    mhash(thread, blob.data(), blob.size());
+
+    const size_t size = mhash_get_block_size(MHASH_SHA256);
+    const unsigned char* digest = static_cast<unsigned char*>(mhash_end(thread));
+
+    std::string result;
+
+    for(size_t i = 0; i < size; ++i) {
+        result.push_back(hex[digest[i] >> 4]);
+        result.push_back(hex[digest[i] & 0x0F]);
+    }
+
+    ::free(const_cast<unsigned char*>(digest));
+
+    return result;
+}
+
+// Makes the target a copy of the source file, sharing the data blocks with it copy-on-write if the
+// filesystem supports it. For the read-only apps, the target is hard linked to the source instead.
 void
-process_t::spool() {
-    std::string blob;
+clone(const fs::path& source, const fs::path& target, bool link) {
+    if(link) {
+        boost::system::error_code ec;
+
+        fs::create_hard_link(source, target, ec);
+
+        if(!ec) {
+            return;
+        }
+
+        // The cache might be on a different filesystem, fall back to a copy.
+    }
+
+#if defined(FICLONE)
+    const int input = ::open(source.c_str(), O_RDONLY);
+
+    if(input != -1) {
+        struct stat info;
+
+        ::fstat(input, &info);
+
+        const int output = ::open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL, info.st_mode & 07777);
+
+        if(output != -1) {
+            const int rv = ::ioctl(output, FICLONE, input);
+
+            ::close(output);
+            ::close(input);
+
+            if(rv == 0) {
+                return;
+            }
+
+            // The filesystem doesn't support reflinks, fall back to a plain copy.
+            ::unlink(target.c_str());
+        } else {
+            ::close(input);
+        }
+    }
+#endif
+
+    // NOTE: Never hard link the files of the apps which might modify their working directories, as
+    // this would modify the cached tree and all the other apps deployed from it as well. Without
+    // reflinks, this means that every deployment costs a full copy of the extracted archive, both
+    // in I/O and in disk space, on top of the cached tree itself.
+    fs::copy_file(source, target);
+}
+
+// Recreates the directory tree of the source in the target, cloning the regular files.
+void
+replicate(const fs::path& source, const fs::path& target, bool link) {
+    const size_t prefix = source.string().size() + 1;
+
+    fs::create_directories(target);
+
+    for(fs::recursive_directory_iterator it(source), end; it != end; ++it) {
+        const fs::path path = target / it->path().string().substr(prefix);
+        const fs::file_status status = fs::symlink_status(it->path());
+
+        if(fs::is_directory(status)) {
+            fs::create_directory(path);
+        } else if(fs::is_symlink(status)) {
+            std::vector<char> buffer(PATH_MAX + 1);
+
+            const ssize_t size = ::readlink(it->path().c_str(), buffer.data(), PATH_MAX);
+
+            if(size == -1 || ::symlink(std::string(buffer.data(), size).c_str(), path.c_str()) != 0) {
+                throw cocaine::error_t("unable to copy the symlink '%s'", it->path().string());
+            }
+        } else {
+            clone(it->path(), path, link);
+        }
+    }
+}
+
+// Serializes the extraction of identical archives, so that the apps sharing an archive being started
+// at once extract it only once. Also tracks the archives being deployed, so that they're not pruned
+// from the cache in the meantime.
+struct extraction_lock_t {
+    extraction_lock_t(const std::string& digest_):
+        digest(digest_)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while(pending.count(digest)) {
+            released.wait(lock);
+        }
+
+        pending.insert(digest);
+    }
+
+   ~extraction_lock_t() {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        pending.erase(digest);
+        released.notify_all();
+    }
+
+    const std::string digest;
+
+    static std::mutex mutex;
+    static std::condition_variable released;
+    static std::set<std::string> pending;
+    static std::multiset<std::string> deploying;
+};
 
-    COCAINE_LOG_INFO(m_log, "deploying the app to '%s'", m_working_directory);
+std::mutex extraction_lock_t::mutex;
+std::condition_variable extraction_lock_t::released;
+std::set<std::string> extraction_lock_t::pending;
+std::multiset<std::string> extraction_lock_t::deploying;
+
+struct deployment_t {
+    deployment_t(const std::string& digest_):
+        digest(digest_)
+    {
+        std::lock_guard<std::mutex> guard(extraction_lock_t::mutex);
+        extraction_lock_t::deploying.insert(digest);
+    }
+
+   ~deployment_t() {
+        std::lock_guard<std::mutex> guard(extraction_lock_t::mutex);
+        extraction_lock_t::deploying.erase(extraction_lock_t::deploying.find(digest));
+    }
+
+    const std::string digest;
+};
+
+// Removes the extracted archives which are neither deployed by any app according to the markers, nor
+// being deployed right now.
+void
+prune(const fs::path& cache) {
+    std::set<std::string> referenced;
+
+    const fs::path markers = cache / "apps";
+
+    if(fs::exists(markers)) {
+        for(fs::directory_iterator it(markers), end; it != end; ++it) {
+            std::string digest;
+
+            std::ifstream stream(it->path().string().c_str());
+            stream >> digest;
+
+            referenced.insert(digest);
+        }
+    }
+
+    std::vector<fs::path> victims;
+
+    {
+        std::lock_guard<std::mutex> guard(extraction_lock_t::mutex);
+
+        for(fs::directory_iterator it(cache), end; it != end; ++it) {
+            const std::string name = it->path().filename().string();
+
+            // Collect the trees left over by the interrupted prunes.
+            if(it->path().extension() == ".trash") {
+                victims.push_back(it->path());
+                continue;
+            }
+
+            // Skip the markers, the partially extracted archives and the staging trees.
+            if(name == "apps" || it->path().has_extension()) {
+                continue;
+            }
+
+            if(referenced.count(name) || extraction_lock_t::deploying.count(name)) {
+                continue;
+            }
+
+            // NOTE: Removing a tree might take a while, so the victims are only renamed aside under
+            // the lock, which is enough for them to be out of sight of the deployments, and removed
+            // once it's released.
+            const fs::path trash = cache / (name + "." + unique_id_t().string() + ".trash");
+
+            boost::system::error_code ec;
+
+            fs::rename(it->path(), trash, ec);
+
+            if(!ec) {
+                victims.push_back(trash);
+            }
+        }
+    }
+
+    for(auto it = victims.begin(); it != victims.end(); ++it) {
+        boost::system::error_code ec;
+
+        fs::remove_all(*it, ec);
+    }
+}
+
+} // namespace
+
+void
+process_t::spool() {
+    api::blob_t blob;
 
     auto storage = api::storage(m_context, "core");
 
     try {
-        blob = storage->get<std::string>("apps", m_name);
+        blob = storage->get_view("apps", m_name);
     } catch(const storage_error_t& e) {
         COCAINE_LOG_ERROR(m_log, "unable to fetch the app from the storage - %s", e.what());
         throw cocaine::error_t("the '%s' app is not available", m_name);
     }
 
+    const std::string digest = digest_of(blob);
+
+    // Digest of the archive which has been deployed to the working directory the last time.
+    const fs::path marker = m_spool_cache / "apps" / m_name;
+
+    if(fs::exists(m_working_directory) && fs::exists(marker)) {
+        std::string deployed;
+
+        std::ifstream stream(marker.string().c_str());
+        stream >> deployed;
+
+        if(deployed == digest) {
+            COCAINE_LOG_INFO(m_log, "the app is already deployed to '%s'", m_working_directory);
+            return;
+        }
+    }
+
+    const fs::path source = m_spool_cache / digest;
+
+    // Keeps the extracted archive in the cache until the deployment is finished.
+    deployment_t deployment(digest);
+
     try {
-        archive_t archive(m_context, blob);
+        fs::create_directories(marker.parent_path());
+
+        {
+            extraction_lock_t lock(digest);
+
+            if(!fs::exists(source)) {
+                // NOTE: The archive is extracted aside and renamed, so that a partially extracted
+                // tree never gets into the cache.
+                const fs::path partial = m_spool_cache / (digest + ".partial");
+
+                fs::remove_all(partial);
+
+                archive_t archive(m_context, blob);
 
 #if BOOST_VERSION >= 104600
-        archive.deploy(m_working_directory.native());
+                archive.deploy(partial.native());
 #else
-        archive.deploy(m_working_directory.string());
+                archive.deploy(partial.string());
 #endif
+
+                fs::rename(partial, source);
+            } else {
+                COCAINE_LOG_INFO(m_log, "the app archive is already extracted, digest: %s", digest);
+            }
+        }
+
+        COCAINE_LOG_INFO(m_log, "deploying the app to '%s'", m_working_directory);
+
+        const fs::path staging = m_spool_cache / (m_name + ".staging");
+
+        fs::remove_all(staging);
+
+        replicate(source, staging, m_read_only);
+
+        fs::remove_all(m_working_directory);
+        fs::rename(staging, m_working_directory);
+
+        {
+            std::ofstream stream(marker.string().c_str(), std::ios::trunc);
+            stream << digest;
+        }
+
+        // The previously deployed archive of this app might not be referenced anymore.
+        prune(m_spool_cache);
     } catch(const archive_error_t& e) {
         COCAINE_LOG_ERROR(m_log, "unable to extract the app files - %s", e.what());
         throw cocaine::error_t("the '%s' app is not available", m_name);
+    } catch(const fs::filesystem_error& e) {
+        COCAINE_LOG_ERROR(m_log, "unable to deploy the app files - %s", e.what());
+        throw cocaine::error_t("the '%s' app is not available", m_name);
     }
 }
-
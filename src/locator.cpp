@@ -32,6 +32,7 @@
 #include "cocaine/context.hpp"
 
 #include "cocaine/detail/actor.hpp"
+#include "cocaine/detail/chamber.hpp"
 #include "cocaine/detail/group.hpp"
 
 #include "cocaine/idl/streaming.hpp"
@@ -54,12 +55,15 @@ using namespace cocaine::io;
 using namespace std::placeholders;
 
 #include "routing.inl"
+#include "gossip.inl"
 
 locator_t::locator_t(context_t& context, reactor_t& reactor):
     dispatch<io::locator_tag>("service/locator"),
     m_context(context),
     m_log(new logging::log_t(context, "service/locator")),
     m_reactor(reactor),
+    m_resolver_reactor(std::make_shared<reactor_t>()),
+    m_lifetime(std::make_shared<int>(0)),
     m_router(new router_t(*m_log.get()))
 {
     // NOTE: Slot for the io::locator::synchronize action is bound in context_t::bootstrap(), as
@@ -69,6 +73,8 @@ locator_t::locator_t(context_t& context, reactor_t& reactor):
 
     COCAINE_LOG_INFO(m_log, "this node's id is '%s'", m_context.config.network.uuid);
 
+    m_resolver = std::make_unique<io::chamber_t>("locator/resolver", m_resolver_reactor);
+
     try {
         auto groups = api::storage(context, "core")->find("groups", std::vector<std::string>({
             "group",
@@ -84,6 +90,17 @@ locator_t::locator_t(context_t& context, reactor_t& reactor):
 
     if(m_context.config.network.group) {
         connect();
+    } else if(m_context.config.network.gossip) {
+        if(m_context.config.network.gateway) {
+            m_gateway = m_context.get<api::gateway_t>(
+                m_context.config.network.gateway.get().type,
+                m_context,
+                "service/locator",
+                m_context.config.network.gateway.get().args
+            );
+        }
+
+        m_gossip.reset(new gossip_t(*this, m_context.config.network.gossip.get()));
     }
 }
 
@@ -352,7 +369,106 @@ locator_t::on_announce_event(ev::io&, int) {
         return;
     }
 
-    if(m_remotes.find(node) != m_remotes.end()) {
+    link(node);
+}
+
+void
+locator_t::on_announce_timer(ev::timer&, int) {
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    packer << remote_id_t(
+        m_context.config.network.uuid,
+        m_context.config.network.hostname,
+        m_context.config.network.locator
+    );
+
+    std::error_code ec;
+
+    if(m_announce->write(buffer.data(), buffer.size(), ec) != static_cast<ssize_t>(buffer.size())) {
+        if(ec) {
+            COCAINE_LOG_ERROR(m_log, "unable to announce the node - [%d] %s", ec.value(), ec.message());
+        } else {
+            COCAINE_LOG_ERROR(m_log, "unable to announce the node");
+        }
+    }
+}
+
+namespace {
+
+// Delays between the attempts to connect to a remote node, doubled after every failure.
+const double link_backoff_min = 1.0;
+const double link_backoff_max = 60.0;
+
+// Resolves the remote node and connects to it on the resolver thread, then posts the connected socket
+// back to the locator reactor. The result is discarded if the locator has been destroyed meanwhile.
+struct link_job_t {
+    typedef std::shared_ptr<io::socket<io::tcp>> socket_type;
+    typedef std::function<void(const socket_type&, const std::error_code&)> callback_type;
+
+    void
+    operator()() const {
+        std::vector<io::tcp::endpoint> endpoints;
+        std::error_code ec;
+
+        try {
+            endpoints = io::resolver<io::tcp>::query(hostname, port);
+        } catch(const std::system_error& e) {
+            COCAINE_LOG_ERROR(log, "unable to resolve node '%s' endpoints - [%d] %s", uuid, e.code().value(),
+                e.code().message());
+            reactor.post(std::bind(&link_job_t::deliver, lifetime, callback, socket_type(), e.code()));
+            return;
+        }
+
+        socket_type socket;
+
+        for(auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+            try {
+                socket = std::make_shared<io::socket<io::tcp>>(*it);
+            } catch(const std::system_error& e) {
+                COCAINE_LOG_WARNING(log, "unable to connect to node '%s' via endpoint '%s' - [%d] %s", uuid,
+                    *it, e.code().value(), e.code().message());
+                ec = e.code();
+                continue;
+            }
+
+            break;
+        }
+
+        reactor.post(std::bind(&link_job_t::deliver, lifetime, callback, socket, ec));
+    }
+
+    static
+    void
+    deliver(const std::weak_ptr<void>& lifetime, const callback_type& callback, const socket_type& socket,
+            const std::error_code& ec)
+    {
+        if(!lifetime.expired()) {
+            callback(socket, ec);
+        }
+    }
+
+    const std::string uuid;
+    const std::string hostname;
+    const uint16_t port;
+
+    logging::log_t& log;
+    io::reactor_t& reactor;
+    const std::weak_ptr<void> lifetime;
+    const callback_type callback;
+};
+
+} // namespace
+
+void
+locator_t::link(const remote_id_t& node) {
+    if(!m_gateway || m_remotes.count(node) || m_linking.count(node)) {
+        return;
+    }
+
+    auto backoff = m_backoff.find(node);
+
+    if(backoff != m_backoff.end() && m_reactor.native().now() < backoff->second.retry) {
         return;
     }
 
@@ -364,38 +480,48 @@ locator_t::on_announce_event(ev::io&, int) {
 
     COCAINE_LOG_INFO(m_log, "discovered node '%s' on '%s:%d'", uuid, hostname, port);
 
-    std::vector<io::tcp::endpoint> endpoints;
+    m_linking.insert(node);
 
-    try {
-        endpoints = io::resolver<io::tcp>::query(hostname, port);
-    } catch(const std::system_error& e) {
-        COCAINE_LOG_ERROR(m_log, "unable to resolve node '%s' endpoints - [%d] %s", uuid, e.code().value(),
-            e.code().message());
+    link_job_t job = {
+        uuid,
+        hostname,
+        port,
+        *m_log,
+        m_reactor,
+        m_lifetime,
+        std::bind(&locator_t::on_link, this, node, _1, _2)
+    };
+
+    m_resolver_reactor->post(job);
+}
+
+void
+locator_t::on_link(const remote_id_t& node, const std::shared_ptr<io::socket<io::tcp>>& socket,
+                   const std::error_code& ec)
+{
+    // The node might have been dropped while it was being connected to.
+    if(!m_linking.erase(node)) {
         return;
     }
 
-    std::unique_ptr<io::channel<io::socket<io::tcp>>> channel;
+    const std::string& uuid = std::get<0>(node);
 
-    for(auto it = endpoints.begin(); it != endpoints.end(); ++it) {
-        try {
-            channel = std::make_unique<io::channel<io::socket<io::tcp>>>(
-                m_reactor,
-                std::make_shared<io::socket<io::tcp>>(*it)
-            );
-        } catch(const std::system_error& e) {
-            COCAINE_LOG_WARNING(m_log, "unable to connect to node '%s' via endpoint '%s' - [%d] %s", uuid, *it,
-                e.code().value(), e.code().message());
-            continue;
-        }
+    if(!socket) {
+        backoff_t& backoff = m_backoff[node];
 
-        break;
-    }
+        backoff.delay = std::min(std::max(backoff.delay * 2, link_backoff_min), link_backoff_max);
+        backoff.retry = m_reactor.native().now() + backoff.delay;
+
+        COCAINE_LOG_ERROR(m_log, "unable to connect to node '%s', retrying in %.0f seconds - [%d] %s", uuid,
+            backoff.delay, ec.value(), ec.message());
 
-    if(!channel) {
-        COCAINE_LOG_ERROR(m_log, "unable to connect to node '%s'", hostname);
         return;
     }
 
+    m_backoff.erase(node);
+
+    auto channel = std::make_unique<io::channel<io::socket<io::tcp>>>(m_reactor, socket);
+
     channel->rd->bind(
         std::bind(&locator_t::on_message, this, node, _1),
         std::bind(&locator_t::on_failure, this, node, _1)
@@ -421,25 +547,26 @@ locator_t::on_announce_event(ev::io&, int) {
 }
 
 void
-locator_t::on_announce_timer(ev::timer&, int) {
-    msgpack::sbuffer buffer;
-    msgpack::packer<msgpack::sbuffer> packer(buffer);
+locator_t::drop(const remote_id_t& node) {
+    m_linking.erase(node);
+    m_backoff.erase(node);
 
-    packer << remote_id_t(
-        m_context.config.network.uuid,
-        m_context.config.network.hostname,
-        m_context.config.network.locator
-    );
+    auto it = m_remotes.find(node);
 
-    std::error_code ec;
+    if(it == m_remotes.end()) {
+        return;
+    }
 
-    if(m_announce->write(buffer.data(), buffer.size(), ec) != static_cast<ssize_t>(buffer.size())) {
-        if(ec) {
-            COCAINE_LOG_ERROR(m_log, "unable to announce the node - [%d] %s", ec.value(), ec.message());
-        } else {
-            COCAINE_LOG_ERROR(m_log, "unable to announce the node");
-        }
+    const std::string uuid = std::get<0>(node);
+
+    auto removed = m_router->remove_remote(uuid);
+
+    for(auto service = removed.begin(); service != removed.end(); ++service) {
+        m_gateway->cleanup(uuid, service->first);
     }
+
+    it->second->detach();
+    m_remotes.erase(it);
 }
 
 void
@@ -467,12 +594,5 @@ locator_t::on_failure(const remote_id_t& node, const std::error_code& ec) {
         COCAINE_LOG_WARNING(m_log, "node '%s' has unexpectedly disconnected", uuid);
     }
 
-    auto removed = m_router->remove_remote(uuid);
-
-    for(auto it = removed.begin(); it != removed.end(); ++it) {
-        m_gateway->cleanup(uuid, it->first);
-    }
-
-    m_remotes[node]->detach();
-    m_remotes.erase(node);
+    drop(node);
 }
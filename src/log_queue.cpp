@@ -0,0 +1,290 @@
+/*
+    Copyright (c) 2011-2014 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2014 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/detail/log_queue.hpp"
+
+#include "cocaine/format.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace cocaine::logging;
+
+namespace {
+
+size_t
+ring_capacity(size_t limit) {
+    size_t capacity = 2;
+
+    while(capacity < limit) {
+        capacity <<= 1;
+    }
+
+    return capacity;
+}
+
+} // namespace
+
+log_queue_t::log_queue_t(blackhole::synchronized<logger_t>& logger, const async_options_t& options):
+    m_logger(logger),
+    m_options(options),
+    m_mask(ring_capacity(options.limit) - 1),
+    m_ring(new cell_t[m_mask + 1]),
+    m_head(0),
+    m_tail(0),
+    m_dropped(0),
+    m_sampled(0),
+    m_reported(0),
+    m_stopped(false),
+    m_sleeping(false)
+{
+    for(size_t i = 0; i <= m_mask; ++i) {
+        m_ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_thread = std::thread(&log_queue_t::run, this);
+}
+
+log_queue_t::~log_queue_t() {
+    m_stopped = true;
+
+    wakeup();
+
+    m_thread.join();
+}
+
+bool
+log_queue_t::admit(priorities level) {
+    if(m_options.overflow != async_options_t::sample || level <= priorities::warning) {
+        return true;
+    }
+
+    if(size() <= (m_mask + 1) / 2) {
+        return true;
+    }
+
+    if(m_sampled++ % std::max<size_t>(m_options.rate, 1) == 0) {
+        return true;
+    }
+
+    ++m_dropped;
+
+    return false;
+}
+
+void
+log_queue_t::push(record_type&& record) {
+    while(!try_push(record)) {
+        if(m_options.overflow != async_options_t::block) {
+            ++m_dropped;
+            return;
+        }
+
+        // Let the writer free some space.
+        wakeup();
+        std::this_thread::yield();
+    }
+
+    if(m_sleeping.load()) {
+        wakeup();
+    }
+}
+
+void
+log_queue_t::push(std::vector<record_type>&& records) {
+    if(records.empty()) {
+        return;
+    }
+
+    if(!try_push(records)) {
+        for(auto it = records.begin(); it != records.end(); ++it) {
+            push(std::move(*it));
+        }
+
+        return;
+    }
+
+    if(m_sleeping.load()) {
+        wakeup();
+    }
+}
+
+uint64_t
+log_queue_t::dropped() const {
+    return m_dropped.load();
+}
+
+// This is the bounded multi-producer queue by Dmitry Vyukov: every cell has a sequence number,
+// which tells whether the cell is free for the producer at this position or ready for the consumer.
+
+bool
+log_queue_t::try_push(record_type& record) {
+    size_t position = m_head.load(std::memory_order_relaxed);
+    cell_t* cell;
+
+    while(true) {
+        cell = &m_ring[position & m_mask];
+
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t difference = intptr_t(sequence) - intptr_t(position);
+
+        if(difference == 0) {
+            if(m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if(difference < 0) {
+            // The cell is still occupied by the record pushed one lap ago, the ring is full.
+            return false;
+        } else {
+            position = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->record = std::move(record);
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool
+log_queue_t::try_push(std::vector<record_type>& records) {
+    const size_t count = records.size();
+
+    if(count > m_mask + 1) {
+        return false;
+    }
+
+    size_t position = m_head.load(std::memory_order_relaxed);
+
+    while(true) {
+        // The cells are freed by the writer in order, so if the last cell of the range is free for
+        // this lap, all the preceding ones are free as well.
+        const cell_t& last = m_ring[(position + count - 1) & m_mask];
+
+        const size_t sequence = last.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = intptr_t(sequence) - intptr_t(position + count - 1);
+
+        if(difference == 0) {
+            if(m_head.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if(difference < 0) {
+            // Not enough room for the whole batch.
+            return false;
+        } else {
+            position = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    for(size_t i = 0; i < count; ++i) {
+        cell_t& cell = m_ring[(position + i) & m_mask];
+
+        cell.record = std::move(records[i]);
+        cell.sequence.store(position + i + 1, std::memory_order_release);
+    }
+
+    return true;
+}
+
+bool
+log_queue_t::try_pop(record_type& record) {
+    // There's only one consumer, so the tail position is not contended.
+    const size_t position = m_tail.load(std::memory_order_relaxed);
+    cell_t& cell = m_ring[position & m_mask];
+
+    if(cell.sequence.load(std::memory_order_acquire) != position + 1) {
+        return false;
+    }
+
+    record = std::move(cell.record);
+    cell.record = record_type();
+
+    m_tail.store(position + 1, std::memory_order_relaxed);
+    cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+
+    return true;
+}
+
+size_t
+log_queue_t::size() const {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    return head > tail ? head - tail : 0;
+}
+
+void
+log_queue_t::wakeup() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wakeup.notify_one();
+}
+
+void
+log_queue_t::run() {
+    record_type record;
+
+    while(true) {
+        if(try_pop(record)) {
+            m_logger.push(std::move(record));
+            continue;
+        }
+
+        report_dropped();
+
+        if(m_stopped.load()) {
+            // The ring is drained and there are no producers left.
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_sleeping = true;
+
+        // Producers check the flag after pushing, so either they see it or the record is seen here.
+        // The wait is bounded anyway, to be on the safe side.
+        if(size() == 0 && !m_stopped.load()) {
+            m_wakeup.wait_for(lock, std::chrono::milliseconds(100));
+        }
+
+        m_sleeping = false;
+    }
+}
+
+void
+log_queue_t::report_dropped() {
+    const uint64_t dropped = m_dropped.load();
+
+    if(dropped == m_reported) {
+        return;
+    }
+
+    auto record = m_logger.open_record(priorities::warning);
+
+    if(record.valid()) {
+        record.attributes.insert(blackhole::keyword::message() = cocaine::format(
+            "dropped %d log records due to the queue overflow", dropped - m_reported
+        ));
+        record.attributes.insert(blackhole::keyword::source() = std::string("logging"));
+
+        m_logger.push(std::move(record));
+    }
+
+    m_reported = dropped;
+}
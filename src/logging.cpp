@@ -21,6 +21,8 @@
 #include "cocaine/logging.hpp"
 #include "cocaine/context.hpp"
 
+#include "cocaine/detail/log_queue.hpp"
+
 using namespace cocaine::logging;
 
 log_t::log_t(context_t& context, const std::string& source):
@@ -38,13 +40,23 @@ log_context_t::log_context_t(blackhole::synchronized<cocaine::logger_t>&& logger
 { }
 
 log_context_t::log_context_t(log_context_t&& other) :
-    m_verbosity(other.m_verbosity),
+    m_verbosity(other.m_verbosity.load()),
     m_logger(std::move(other.m_logger))
-{ }
+{
+    // The writer thread is bound to the logger, so it can't be moved along.
+    BOOST_ASSERT(!other.m_queue);
+}
+
+log_context_t::~log_context_t() {
+    // Flush the queued records while the logger is still alive.
+    m_queue.reset();
+}
 
 log_context_t&
 log_context_t::operator=(log_context_t&& other) {
-    m_verbosity = other.m_verbosity;
+    BOOST_ASSERT(!m_queue && !other.m_queue);
+
+    m_verbosity = other.m_verbosity.load();
     m_logger = std::move(other.m_logger);
     return *this;
 }
@@ -52,20 +64,103 @@ log_context_t::operator=(log_context_t&& other) {
 void
 log_context_t::set_verbosity(priorities value) {
     m_verbosity = value;
-    m_logger.set_filter(blackhole::keyword::severity<priorities>() <= value);
+
+    // In the asynchronous mode, the logger state must stay intact, as records are opened without
+    // the logger lock. The verbosity is checked in open_record() anyway.
+    if(!m_queue) {
+        m_logger.set_filter(blackhole::keyword::severity<priorities>() <= value);
+    }
+}
+
+void
+log_context_t::set_async(const async_options_t& options) {
+    m_queue.reset();
+
+    // The records are filtered by the verbosity before they are opened, so the logger filter lets
+    // everything through from now on, and is never changed again.
+    m_logger.set_filter(blackhole::keyword::severity<priorities>() <= priorities::debug);
+
+    m_queue.reset(new log_queue_t(m_logger, options));
 }
 
 namespace bhl = blackhole::log;
 
-void
-log_context_t::emit(priorities level, const std::string& source, const std::string& message, const bhl::attributes_t& attributes) {
-    auto record = m_logger.open_record(level);
+bhl::record_t
+log_context_t::open_record(priorities level) {
+    // Same as the logger filter, but doesn't lock the logger for the records which are going to be
+    // filtered out anyway.
+    if(level > m_verbosity.load(std::memory_order_relaxed)) {
+        return bhl::record_t();
+    }
+
+    if(!m_queue) {
+        return m_logger.open_record(level);
+    }
+
+    if(!m_queue->admit(level)) {
+        return bhl::record_t();
+    }
+
+    // NOTE: The writer thread holds the logger lock for the whole sink I/O, so the calling threads
+    // open the records bypassing the lock. This is safe, because opening a record only reads the
+    // filter and the attributes, which are not modified in the asynchronous mode, while the writer
+    // only touches the frontends.
+    return m_logger.log().open_record(level);
+}
+
+bhl::record_t
+log_context_t::open_record(priorities level, const std::string& source, const std::string& message, const bhl::attributes_t& attributes) {
+    auto record = open_record(level);
 
     if(record.valid()) {
         record.attributes.insert(attributes.begin(), attributes.end());
         record.attributes.insert(blackhole::keyword::message() = message);
         record.attributes.insert(blackhole::keyword::source() = source);
+    }
+
+    return record;
+}
+
+void
+log_context_t::push(bhl::record_t&& record) {
+    if(m_queue) {
+        m_queue->push(std::move(record));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_push_mutex);
+
+    // NOTE: The records are pushed bypassing the logger lock, which is held by the synchronized
+    // wrapper only for the duration of a single call, so that a batch could be pushed under a single
+    // lock acquisition. This is safe for the same reason as opening the records bypassing the lock
+    // is in the asynchronous mode: pushing only touches the frontends, which are never modified
+    // after the logger is configured, while the filter is guarded by the logger lock as before.
+    m_logger.log().push(std::move(record));
+}
+
+void
+log_context_t::push(std::vector<bhl::record_t>&& records) {
+    if(records.empty()) {
+        return;
+    }
+
+    if(m_queue) {
+        m_queue->push(std::move(records));
+        return;
+    }
 
-        m_logger.push(std::move(record));
+    std::lock_guard<std::mutex> lock(m_push_mutex);
+
+    for(auto it = records.begin(); it != records.end(); ++it) {
+        m_logger.log().push(std::move(*it));
+    }
+}
+
+void
+log_context_t::emit(priorities level, const std::string& source, const std::string& message, const bhl::attributes_t& attributes) {
+    auto record = open_record(level, source, message, attributes);
+
+    if(record.valid()) {
+        push(std::move(record));
     }
 }
@@ -22,17 +22,30 @@
 #include "cocaine/detail/raft/control_service.hpp"
 #include "cocaine/detail/raft/configuration_machine.hpp"
 #include "cocaine/detail/raft/entry.hpp"
+#include "cocaine/detail/raft/heartbeats.hpp"
+#include "cocaine/detail/raft/journal.hpp"
 #include "cocaine/detail/raft/repository.hpp"
 
 #include "cocaine/detail/actor.hpp"
 
 #include "cocaine/logging.hpp"
 
+#include "cocaine/traits/tuple.hpp"
 #include "cocaine/traits/vector.hpp"
 
+#include <boost/crc.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 using namespace cocaine;
 using namespace cocaine::raft;
 
+namespace fs = boost::filesystem;
+
 std::error_code
 cocaine::make_error_code(raft_errc e) {
     return std::error_code(static_cast<int>(e), raft_category());
@@ -76,6 +89,234 @@ raft::repository_t::get(const std::string& name) const {
     }
 }
 
+std::shared_ptr<heartbeat_channel_t>
+raft::repository_t::heartbeats(const node_id_t& node) {
+    auto channels = m_heartbeats.synchronize();
+
+    auto channel = (*channels)[node].lock();
+
+    if(!channel) {
+        for(auto it = channels->begin(); it != channels->end();) {
+            if(it->second.expired()) {
+                channels->erase(it++);
+            } else {
+                ++it;
+            }
+        }
+
+        // NOTE: Not allocated along with the control block, which is held by the weak pointer in
+        // the map until the next sweep.
+        channel.reset(new heartbeat_channel_t(m_context, *m_reactor, node));
+
+        (*channels)[node] = channel;
+    }
+
+    return channel;
+}
+
+heartbeat_channel_t::heartbeat_channel_t(context_t& context, io::reactor_t& reactor, const node_id_t& node):
+    m_context(context),
+    m_reactor(reactor),
+    m_node(node),
+    m_logger(new logging::log_t(context, cocaine::format("raft/heartbeats/%s:%d", node.first, node.second))),
+    m_ticker(reactor.native()),
+    m_flusher(reactor.native())
+{
+    m_ticker.set<heartbeat_channel_t, &heartbeat_channel_t::on_tick>(this);
+    m_flusher.set<heartbeat_channel_t, &heartbeat_channel_t::on_flush>(this);
+}
+
+heartbeat_channel_t::~heartbeat_channel_t() {
+    if(m_ticker.is_active()) {
+        m_ticker.stop();
+    }
+
+    if(m_flusher.is_active()) {
+        m_flusher.stop();
+    }
+}
+
+std::shared_ptr<heartbeat_channel_t::tick_handler_t>
+heartbeat_channel_t::subscribe(const tick_handler_t& handler) {
+    auto subscription = std::make_shared<tick_handler_t>(handler);
+
+    m_subscribers.push_back(subscription);
+
+    if(!m_ticker.is_active()) {
+        const float interval = float(m_context.raft().options().heartbeat_timeout) / 1000.0;
+        m_ticker.start(interval, interval);
+    }
+
+    return subscription;
+}
+
+void
+heartbeat_channel_t::send(const std::string& machine,
+                          uint64_t term,
+                          const node_id_t& leader,
+                          const std::tuple<uint64_t, uint64_t>& prev_entry,
+                          uint64_t commit_index,
+                          const callback_type& callback)
+{
+    m_batch.emplace_back(machine, term, leader, prev_entry, commit_index);
+    m_callbacks.push_back(callback);
+
+    if(!m_flusher.is_active()) {
+        m_flusher.start();
+    }
+}
+
+namespace {
+
+struct expired_subscription {
+    template<class T>
+    bool
+    operator()(const std::weak_ptr<T>& ptr) const {
+        return ptr.expired();
+    }
+};
+
+} // namespace
+
+void
+heartbeat_channel_t::on_tick(ev::timer&, int) {
+    m_subscribers.erase(
+        std::remove_if(m_subscribers.begin(), m_subscribers.end(), expired_subscription()),
+        m_subscribers.end()
+    );
+
+    if(m_subscribers.empty()) {
+        m_ticker.stop();
+        return;
+    }
+
+    // The subscribers may unsubscribe while they are ticked.
+    auto subscribers = m_subscribers;
+
+    for(auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+        if(auto handler = it->lock()) {
+            (*handler)();
+        }
+    }
+}
+
+void
+heartbeat_channel_t::on_flush(ev::idle&, int) {
+    m_flusher.stop();
+
+    if(m_batch.empty()) {
+        return;
+    }
+
+    if(!m_client) {
+        if(!m_resolver) {
+            COCAINE_LOG_DEBUG(m_logger, "client is not connected, connecting...");
+
+            m_resolver = std::make_shared<service_resolver_t>(
+                m_reactor,
+                io::resolver<io::tcp>::query(m_node.first, m_node.second),
+                m_context.raft().options().node_service_name
+            );
+
+            using namespace std::placeholders;
+
+            m_resolver->bind(std::bind(&heartbeat_channel_t::on_connected, this, _1),
+                             std::bind(&heartbeat_channel_t::on_connection_error, this, _1));
+        }
+
+        // The batch will be sent, when the connection is established.
+        return;
+    }
+
+    COCAINE_LOG_DEBUG(m_logger, "sending %d heartbeats", m_batch.size());
+
+    auto callbacks = std::make_shared<std::vector<callback_type>>();
+    callbacks->swap(m_callbacks);
+
+    std::vector<heartbeat_type> batch;
+    batch.swap(m_batch);
+
+    typedef io::raft_node<msgpack::object, msgpack::object> protocol;
+
+    m_client->call<protocol::heartbeat>(
+        make_proxy<std::tuple<std::vector<std::tuple<uint64_t, bool>>>>(
+            std::bind(&heartbeat_channel_t::on_response, callbacks, std::placeholders::_1)
+        ),
+        batch
+    );
+}
+
+void
+heartbeat_channel_t::on_connected(const std::shared_ptr<client_t>& client) {
+    m_resolver.reset();
+
+    m_client = client;
+    m_client_subscription = m_client->subscribe(
+        std::bind(&heartbeat_channel_t::on_error, this, std::placeholders::_1)
+    );
+
+    if(!m_batch.empty() && !m_flusher.is_active()) {
+        m_flusher.start();
+    }
+}
+
+void
+heartbeat_channel_t::on_connection_error(const std::error_code& ec) {
+    COCAINE_LOG_DEBUG(m_logger, "unable to connect to raft service: [%d] %s", ec.value(), ec.message());
+
+    m_resolver.reset();
+
+    drop_batch(ec);
+}
+
+void
+heartbeat_channel_t::on_error(const std::error_code& ec) {
+    COCAINE_LOG_DEBUG(m_logger, "connection error: [%d] %s", ec.value(), ec.message());
+
+    // Release the connection. It's shared with other users, so it's up to the pool to close it.
+    m_client_subscription.reset();
+    m_client.reset();
+}
+
+void
+heartbeat_channel_t::drop_batch(const std::error_code& ec) {
+    std::vector<callback_type> callbacks;
+    callbacks.swap(m_callbacks);
+
+    m_batch.clear();
+
+    for(auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+        (*it)(ec);
+    }
+}
+
+void
+heartbeat_channel_t::on_response(const std::shared_ptr<std::vector<callback_type>>& callbacks,
+                                 response_type response)
+{
+    typedef std::tuple<std::vector<std::tuple<uint64_t, bool>>> results_type;
+
+    if(boost::get<results_type>(&response)) {
+        const auto& results = std::get<0>(boost::get<results_type>(response));
+
+        // Results are in the order of the heartbeats. Missing ones mean a malformed response.
+        for(size_t i = 0; i < callbacks->size(); ++i) {
+            if(i < results.size() && std::get<0>(results[i]) == 0) {
+                // Zero term is never replied by a real actor, see node_service_t::heartbeat().
+                (*callbacks)[i](std::error_code(raft_errc::unknown_machine));
+            } else if(i < results.size()) {
+                (*callbacks)[i](results[i]);
+            } else {
+                (*callbacks)[i](std::make_error_code(std::errc::protocol_error));
+            }
+        }
+    } else {
+        for(auto it = callbacks->begin(); it != callbacks->end(); ++it) {
+            (*it)(boost::get<std::error_code>(response));
+        }
+    }
+}
+
 node_service_t::node_service_t(context_t& context, io::reactor_t& reactor, const std::string& name):
     api::service_t(context, reactor, name, dynamic_t::empty_object),
     dispatch<io::raft_node_tag<msgpack::object, msgpack::object>>(name),
@@ -87,10 +328,11 @@ node_service_t::node_service_t(context_t& context, io::reactor_t& reactor, const
     typedef io::raft_node<msgpack::object, msgpack::object> protocol;
 
     on<protocol::append>(std::bind(&node_service_t::append, this, _1, _2, _3, _4, _5, _6));
-    on<protocol::apply>(std::bind(&node_service_t::apply, this, _1, _2, _3, _4, _5, _6));
+    on<protocol::apply>(std::bind(&node_service_t::apply, this, _1, _2, _3, _4, _5, _6, _7, _8));
     on<protocol::request_vote>(std::bind(&node_service_t::request_vote, this, _1, _2, _3, _4));
     on<protocol::insert>(std::bind(&node_service_t::insert, this, _1, _2));
     on<protocol::erase>(std::bind(&node_service_t::erase, this, _1, _2));
+    on<protocol::heartbeat>(std::bind(&node_service_t::heartbeat, this, _1));
 }
 
 std::shared_ptr<raft::actor_concept_t>
@@ -115,15 +357,17 @@ node_service_t::append(const std::string& machine,
     return find_machine(machine)->append(term, leader, prev_entry, entries, commit_index);
 }
 
-deferred<std::tuple<uint64_t, bool>>
+deferred<std::tuple<uint64_t, bool, uint64_t>>
 node_service_t::apply(const std::string& machine,
                       uint64_t term,
                       raft::node_id_t leader,
                       std::tuple<uint64_t, uint64_t> snapshot_entry, // index, term
-                      const msgpack::object& snapshot,
+                      uint64_t offset,
+                      const std::string& chunk,
+                      bool done,
                       uint64_t commit_index)
 {
-    return find_machine(machine)->apply(term, leader, snapshot_entry, snapshot, commit_index);
+    return find_machine(machine)->apply(term, leader, snapshot_entry, offset, chunk, done, commit_index);
 }
 
 deferred<std::tuple<uint64_t, bool>>
@@ -135,6 +379,73 @@ node_service_t::request_vote(const std::string& state_machine,
     return find_machine(state_machine)->request_vote(term, candidate, last_entry);
 }
 
+namespace {
+
+// Collects the results of the heartbeats from a batch, which are delivered to different actors.
+struct heartbeat_results_t {
+    typedef std::tuple<uint64_t, bool> result_type;
+
+    heartbeat_results_t(const deferred<std::vector<result_type>>& promise, size_t size):
+        promise(promise),
+        results(size, result_type(0, false)),
+        remaining(size)
+    { }
+
+    void
+    set(size_t index, const result_type& result) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        results[index] = result;
+
+        if(--remaining == 0) {
+            lock.unlock();
+            promise.write(results);
+        }
+    }
+
+    deferred<std::vector<result_type>> promise;
+
+    std::mutex mutex;
+    std::vector<result_type> results;
+    size_t remaining;
+};
+
+} // namespace
+
+deferred<std::vector<std::tuple<uint64_t, bool>>>
+node_service_t::heartbeat(const std::vector<heartbeat_type>& batch) {
+    deferred<std::vector<std::tuple<uint64_t, bool>>> promise;
+
+    if(batch.empty()) {
+        promise.write(std::vector<std::tuple<uint64_t, bool>>());
+        return promise;
+    }
+
+    auto results = std::make_shared<heartbeat_results_t>(promise, batch.size());
+
+    for(size_t i = 0; i < batch.size(); ++i) {
+        const auto& heartbeat = batch[i];
+        auto callback = std::bind(&heartbeat_results_t::set, results, i, std::placeholders::_1);
+
+        auto machine = m_context.raft().get(std::get<0>(heartbeat));
+
+        if(machine) {
+            machine->heartbeat(std::get<1>(heartbeat),
+                               std::get<2>(heartbeat),
+                               std::get<3>(heartbeat),
+                               std::get<4>(heartbeat),
+                               callback);
+        } else {
+            // The batch reply has no room for errors, so unknown state machines are marked with
+            // the zero term. Real actors can't reply with it, because the leader's term is at least
+            // one and followers adopt it before replying.
+            callback(std::make_tuple(uint64_t(0), false));
+        }
+    }
+
+    return promise;
+}
+
 deferred<command_result<void>>
 node_service_t::insert(const std::string& machine, const raft::node_id_t& node) {
     return find_machine(machine)->insert(node);
@@ -180,6 +491,8 @@ control_service_t::control_service_t(context_t& context,
     options.heartbeat_timeout = args.as_object().at("heartbeat_timeout", options.election_timeout / 2).to<unsigned int>();
     options.snapshot_threshold = args.as_object().at("snapshot_threshold", 100000).to<unsigned int>();
     options.message_size = args.as_object().at("message_size", 1000).to<unsigned int>();
+    options.append_window = std::max(1u, args.as_object().at("append_window", 4).to<unsigned int>());
+    options.snapshot_chunk_size = std::max(1u, args.as_object().at("snapshot_chunk_size", 1024 * 1024).to<unsigned int>());
 
     m_context.raft().set_options(options);
     m_context.raft().activate();
@@ -394,3 +707,519 @@ control_service_t::on_config_change_result(
     }
 }
 
+// Journal
+
+namespace {
+
+// Every record is prefixed with the size and the checksum of its payload, both are stored as
+// little-endian 32-bit integers.
+const size_t header_size = 8;
+
+// Segments are rotated when they grow over this size.
+const off_t segment_limit = 64 * 1024 * 1024;
+
+void
+encode(std::string& target, const std::string& blob) {
+    boost::crc_32_type crc;
+    crc.process_bytes(blob.data(), blob.size());
+
+    const uint32_t fields[] = { static_cast<uint32_t>(blob.size()), crc.checksum() };
+
+    for(size_t i = 0; i < 2; ++i) {
+        for(size_t shift = 0; shift < 32; shift += 8) {
+            target.push_back(static_cast<char>((fields[i] >> shift) & 0xFF));
+        }
+    }
+
+    target.append(blob);
+}
+
+uint32_t
+decode(const char* data) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    return static_cast<uint32_t>(bytes[0])
+        | (static_cast<uint32_t>(bytes[1]) << 8)
+        | (static_cast<uint32_t>(bytes[2]) << 16)
+        | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+// Returns the payload size of the record, or nothing if the record is torn or corrupted.
+boost::optional<size_t>
+validate(const char* data, size_t available) {
+    if(available < header_size) {
+        return boost::none;
+    }
+
+    const size_t size = decode(data);
+
+    if(available - header_size < size) {
+        return boost::none;
+    }
+
+    boost::crc_32_type crc;
+    crc.process_bytes(data + header_size, size);
+
+    if(crc.checksum() != decode(data + 4)) {
+        return boost::none;
+    }
+
+    return size;
+}
+
+struct mapping_t {
+    mapping_t(int fd, size_t size_):
+        base(nullptr),
+        size(size_)
+    {
+        if(size == 0) {
+            return;
+        }
+
+        void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(ptr == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category(), "unable to map the journal");
+        }
+
+        base = static_cast<const char*>(ptr);
+    }
+
+   ~mapping_t() {
+        if(base) ::munmap(const_cast<char*>(base), size);
+    }
+
+    const char* base;
+    const size_t size;
+};
+
+void
+write_all(int fd, const char* data, size_t size) {
+    while(size) {
+        const ssize_t length = ::write(fd, data, size);
+
+        if(length == -1) {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category(), "unable to write the journal");
+        }
+
+        data += length;
+        size -= length;
+    }
+}
+
+void
+sync_file(int fd) {
+#ifdef __APPLE__
+    const int rv = ::fsync(fd);
+#else
+    const int rv = ::fdatasync(fd);
+#endif
+
+    if(rv != 0) {
+        throw std::system_error(errno, std::system_category(), "unable to sync the journal");
+    }
+}
+
+void
+sync_directory(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(fd == -1) {
+        throw std::system_error(errno, std::system_category(), "unable to sync the journal");
+    }
+
+    // NOTE: Some filesystems don't support syncing directories, the result is ignored intentionally.
+    ::fsync(fd);
+    ::close(fd);
+}
+
+} // namespace
+
+journal_t::journal_t(const std::string& path):
+    m_path(path),
+    m_dirty_directory(false),
+    m_snapshot_generation(0)
+{
+    try {
+        fs::create_directories(m_path);
+    } catch(const fs::filesystem_error& e) {
+        throw cocaine::error_t("unable to create the raft journal in '%s'", m_path);
+    }
+
+    std::vector<uint64_t> segments;
+
+    for(fs::directory_iterator it(m_path), end; it != end; ++it) {
+#if BOOST_VERSION >= 104600
+        const std::string name = it->path().filename().string();
+#else
+        const std::string name = it->path().filename();
+#endif
+
+        if(name.size() <= 4 || name.compare(name.size() - 4, 4, ".log") != 0) {
+            continue;
+        }
+
+        try {
+            segments.push_back(boost::lexical_cast<uint64_t>(name.substr(0, name.size() - 4)));
+        } catch(const boost::bad_lexical_cast& e) {
+            continue;
+        }
+    }
+
+    std::sort(segments.begin(), segments.end());
+
+    bool corrupted = false;
+
+    for(auto it = segments.begin(); it != segments.end(); ++it) {
+        const std::string path = segment_path(*it);
+
+        // Segments following a corrupted one, or leaving a gap after the previous one, can't be
+        // trusted anymore. Raft will replicate the missing entries once again.
+        if(corrupted ||
+           (!m_segments.empty() && *it != m_segments.back().first + m_segments.back().offsets.size()))
+        {
+            ::unlink(path.c_str());
+            m_dirty_directory = true;
+            continue;
+        }
+
+        segment_t segment;
+
+        segment.first = *it;
+        segment.fd = ::open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+
+        if(segment.fd == -1) {
+            throw std::system_error(errno, std::system_category(), "unable to open the journal");
+        }
+
+        try {
+            recover(segment, corrupted);
+        } catch(...) {
+            ::close(segment.fd);
+            throw;
+        }
+
+        m_segments.push_back(segment);
+    }
+
+    sync();
+}
+
+journal_t::~journal_t() {
+    try {
+        sync();
+    } catch(...) {
+        // Nothing can be done at this point.
+    }
+
+    for(auto it = m_segments.begin(); it != m_segments.end(); ++it) {
+        ::close(it->fd);
+    }
+}
+
+boost::optional<std::string>
+journal_t::state() const {
+    return read_record("state");
+}
+
+boost::optional<std::string>
+journal_t::snapshot() const {
+    return read_record("snapshot");
+}
+
+void
+journal_t::replay(const replay_handler_t& handler) const {
+    BOOST_ASSERT(m_buffer.empty());
+
+    for(auto segment = m_segments.begin(); segment != m_segments.end(); ++segment) {
+        const mapping_t mapping(segment->fd, segment->size);
+
+        for(size_t i = 0; i < segment->offsets.size(); ++i) {
+            const char* record = mapping.base + segment->offsets[i];
+            handler(segment->first + i, record + header_size, decode(record));
+        }
+    }
+}
+
+void
+journal_t::set_state(const std::string& blob) {
+    write_record("state", blob);
+}
+
+void
+journal_t::set_snapshot(uint64_t index, const std::string& blob) {
+    {
+        std::lock_guard<std::mutex> lock(m_snapshot_mutex);
+
+        write_record("snapshot", blob);
+        ++m_snapshot_generation;
+    }
+
+    commit_snapshot(index);
+}
+
+uint64_t
+journal_t::snapshot_generation() const {
+    std::lock_guard<std::mutex> lock(m_snapshot_mutex);
+    return m_snapshot_generation;
+}
+
+bool
+journal_t::store_snapshot(uint64_t generation, const std::string& blob) {
+    std::lock_guard<std::mutex> lock(m_snapshot_mutex);
+
+    // NOTE: A newer snapshot might have been received from the leader while this one was being
+    // taken, it must not be overwritten with an older one.
+    if(generation != m_snapshot_generation) {
+        return false;
+    }
+
+    write_record("snapshot", blob);
+    ++m_snapshot_generation;
+
+    return true;
+}
+
+void
+journal_t::commit_snapshot(uint64_t index) {
+    // NOTE: The segments are dropped only after the snapshot is durable, so that the entries are
+    // never lost, even if the node crashes in between.
+    while(!m_segments.empty()) {
+        const segment_t& segment = m_segments.front();
+
+        if(segment.offsets.empty() || segment.first + segment.offsets.size() - 1 > index) {
+            break;
+        }
+
+        if(m_segments.size() == 1) {
+            m_buffer.clear();
+        }
+
+        drop_segment(segment);
+        m_segments.pop_front();
+    }
+}
+
+void
+journal_t::append(uint64_t index, const std::string& blob) {
+    if(!m_segments.empty() && index != m_segments.back().first + m_segments.back().offsets.size()) {
+        // The log only grows contiguously, so a gap means that the log was reset by a newer snapshot
+        // and the stored entries are obsolete.
+        m_buffer.clear();
+
+        while(!m_segments.empty()) {
+            drop_segment(m_segments.back());
+            m_segments.pop_back();
+        }
+    }
+
+    if(m_segments.empty() || m_segments.back().size >= segment_limit) {
+        open_segment(index);
+    }
+
+    segment_t& segment = m_segments.back();
+
+    const size_t buffered = m_buffer.size();
+
+    encode(m_buffer, blob);
+
+    segment.offsets.push_back(segment.size);
+    segment.size += m_buffer.size() - buffered;
+}
+
+void
+journal_t::truncate(uint64_t index) {
+    flush();
+
+    while(!m_segments.empty() && m_segments.back().first >= index) {
+        drop_segment(m_segments.back());
+        m_segments.pop_back();
+    }
+
+    if(m_segments.empty()) {
+        return;
+    }
+
+    segment_t& segment = m_segments.back();
+
+    const uint64_t count = index - segment.first;
+
+    if(count < segment.offsets.size()) {
+        segment.size = segment.offsets[count];
+        segment.offsets.resize(count);
+
+        if(::ftruncate(segment.fd, segment.size) != 0) {
+            throw std::system_error(errno, std::system_category(), "unable to truncate the journal");
+        }
+
+        m_dirty.insert(segment.fd);
+    }
+}
+
+void
+journal_t::sync() {
+    flush();
+
+    for(auto it = m_dirty.begin(); it != m_dirty.end(); ++it) {
+        sync_file(*it);
+    }
+
+    m_dirty.clear();
+
+    if(m_dirty_directory) {
+        sync_directory(m_path);
+        m_dirty_directory = false;
+    }
+}
+
+std::string
+journal_t::segment_path(uint64_t first) const {
+    return cocaine::format("%s/%020d.log", m_path, first);
+}
+
+void
+journal_t::recover(segment_t& segment, bool& corrupted) {
+    struct stat info;
+
+    if(::fstat(segment.fd, &info) != 0) {
+        throw std::system_error(errno, std::system_category(), "unable to open the journal");
+    }
+
+    const mapping_t mapping(segment.fd, info.st_size);
+
+    off_t offset = 0;
+
+    while(offset < info.st_size) {
+        const auto size = validate(mapping.base + offset, info.st_size - offset);
+
+        if(!size) {
+            corrupted = true;
+            break;
+        }
+
+        segment.offsets.push_back(offset);
+        offset += header_size + *size;
+    }
+
+    if(corrupted) {
+        // Drop the torn tail, which is most likely a result of a crash in the middle of a write.
+        if(::ftruncate(segment.fd, offset) != 0) {
+            throw std::system_error(errno, std::system_category(), "unable to truncate the journal");
+        }
+
+        m_dirty.insert(segment.fd);
+    }
+
+    segment.size = offset;
+}
+
+void
+journal_t::open_segment(uint64_t first) {
+    flush();
+
+    segment_t segment;
+
+    segment.first = first;
+    segment.fd = ::open(segment_path(first).c_str(), O_RDWR | O_APPEND | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    segment.size = 0;
+
+    if(segment.fd == -1) {
+        throw std::system_error(errno, std::system_category(), "unable to create a journal segment");
+    }
+
+    m_segments.push_back(segment);
+    m_dirty_directory = true;
+}
+
+void
+journal_t::drop_segment(const segment_t& segment) {
+    m_dirty.erase(segment.fd);
+    m_dirty_directory = true;
+
+    ::close(segment.fd);
+    ::unlink(segment_path(segment.first).c_str());
+}
+
+void
+journal_t::flush() {
+    if(m_buffer.empty()) {
+        return;
+    }
+
+    write_all(m_segments.back().fd, m_buffer.data(), m_buffer.size());
+
+    m_dirty.insert(m_segments.back().fd);
+    m_buffer.clear();
+}
+
+void
+journal_t::write_record(const std::string& name, const std::string& blob) {
+    const std::string path = m_path + "/" + name;
+    const std::string temp = path + ".tmp";
+
+    std::string record;
+
+    encode(record, blob);
+
+    const int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if(fd == -1) {
+        throw std::system_error(errno, std::system_category(), "unable to write the journal");
+    }
+
+    try {
+        write_all(fd, record.data(), record.size());
+        sync_file(fd);
+    } catch(...) {
+        ::close(fd);
+        throw;
+    }
+
+    ::close(fd);
+
+    if(::rename(temp.c_str(), path.c_str()) != 0) {
+        throw std::system_error(errno, std::system_category(), "unable to write the journal");
+    }
+
+    sync_directory(m_path);
+}
+
+boost::optional<std::string>
+journal_t::read_record(const std::string& name) const {
+    const std::string path = m_path + "/" + name;
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(fd == -1) {
+        if(errno == ENOENT) {
+            return boost::none;
+        }
+
+        throw std::system_error(errno, std::system_category(), "unable to read the journal");
+    }
+
+    struct stat info;
+
+    if(::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::system_error(errno, std::system_category(), "unable to read the journal");
+    }
+
+    const mapping_t mapping(fd, info.st_size);
+
+    ::close(fd);
+
+    const auto size = validate(mapping.base, info.st_size);
+
+    // NOTE: These records are replaced atomically, so a corrupted one means that the disk itself
+    // is broken. It's unsafe to continue, because the node might vote twice in the same term.
+    if(!size) {
+        throw cocaine::error_t("the raft journal record '%s' is corrupted", path);
+    }
+
+    return std::string(mapping.base + header_size, *size);
+}
@@ -20,16 +20,30 @@
 
 #include "cocaine/repository.hpp"
 
+#include "cocaine/traits/map.hpp"
+#include "cocaine/traits/tuple.hpp"
+#include "cocaine/traits/vector.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/filesystem/operations.hpp>
 
 #include <boost/iterator/filter_iterator.hpp>
 
+#include <sys/stat.h>
+
+using namespace cocaine;
 using namespace cocaine::api;
 
 namespace fs = boost::filesystem;
 
-repository_t::repository_t() {
+repository_t::repository_t():
+    m_recording(nullptr)
+{
     if(lt_dlinit() != 0) {
         throw repository_error_t("unable to initialize the dynamic loader");
     }
@@ -71,10 +85,106 @@ struct validate_t {
     }
 };
 
+// Plugin manifests, as stored in the cache: plugin modification time in nanoseconds, inode, size
+// and the categories and types of the components it provides, keyed by the plugin path.
+
+typedef std::tuple<
+    int64_t,
+    uint64_t,
+    uint64_t,
+    std::vector<std::tuple<std::string, std::string>>
+> manifest_t;
+
+typedef std::tuple<int64_t, uint64_t, uint64_t> stamp_t;
+
+stamp_t
+stamp(const std::string& plugin) {
+    struct stat info;
+
+    if(::stat(plugin.c_str(), &info) != 0) {
+        throw std::system_error(errno, std::system_category(), "unable to stat '" + plugin + "'");
+    }
+
+    // NOTE: Seconds are too coarse to notice a plugin being rebuilt in place with the same size, so
+    // the nanosecond part is taken into account too. Plugins replaced by renaming get a new inode.
+#if defined(__APPLE__)
+    const int64_t nanoseconds = info.st_mtimespec.tv_nsec;
+#else
+    const int64_t nanoseconds = info.st_mtim.tv_nsec;
+#endif
+
+    return stamp_t(
+        static_cast<int64_t>(info.st_mtime) * 1000000000 + nanoseconds,
+        info.st_ino,
+        info.st_size
+    );
+}
+
+typedef std::map<std::string, manifest_t> manifest_map_t;
+
+manifest_map_t
+read_manifests(const std::string& cache) {
+    std::ifstream stream(cache.c_str(), std::ios::binary);
+
+    if(!stream) {
+        return manifest_map_t();
+    }
+
+    const std::string blob(
+        (std::istreambuf_iterator<char>(stream)),
+         std::istreambuf_iterator<char>()
+    );
+
+    std::tuple<unsigned int, manifest_map_t> result;
+
+    try {
+        msgpack::unpacked unpacked;
+        msgpack::unpack(&unpacked, blob.data(), blob.size());
+        io::type_traits<std::tuple<unsigned int, manifest_map_t>>::unpack(unpacked.get(), result);
+    } catch(const std::exception& e) {
+        // Corrupted caches are rebuilt from scratch.
+        return manifest_map_t();
+    }
+
+    if(std::get<0>(result) != COCAINE_VERSION) {
+        // Component categories might have changed, as well as the plugins' requirements.
+        return manifest_map_t();
+    }
+
+    return std::get<1>(result);
+}
+
+void
+write_manifests(const std::string& cache, const manifest_map_t& manifests) {
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    io::type_traits<std::tuple<unsigned int, manifest_map_t>>::pack(
+        packer,
+        std::make_tuple(static_cast<unsigned int>(COCAINE_VERSION), manifests)
+    );
+
+    const std::string temporary = cache + ".tmp";
+
+    std::ofstream stream(temporary.c_str(), std::ios::binary | std::ios::trunc);
+
+    // NOTE: The cache is merely an optimization, so failures to write it are ignored. The plugins
+    // will be opened and cached again next time.
+    if(!stream.write(buffer.data(), buffer.size())) {
+        return;
+    }
+
+    stream.close();
+
+    boost::system::error_code ec;
+
+    fs::rename(temporary, cache, ec);
+}
+
 } // namespace
 
 void
-repository_t::load(const std::string& path_) {
+repository_t::load(const std::string& path_, const std::string& cache) {
     const auto path = fs::path(path_);
     const auto status = fs::status(path);
 
@@ -82,6 +192,8 @@ repository_t::load(const std::string& path_) {
         return;
     }
 
+    std::vector<std::string> plugins;
+
     if(fs::is_directory(status)) {
         typedef boost::filter_iterator<
             validate_t,
@@ -92,14 +204,115 @@ repository_t::load(const std::string& path_) {
                           end;
 
         while(it != end) {
-            // Try to load the plugin.
-            open(it->path().string());
+            plugins.push_back(it->path().string());
             ++it;
         }
     } else {
         // Just try to open the file.
-        open(path.string());
+        plugins.push_back(path.string());
     }
+
+    if(cache.empty()) {
+        for(auto it = plugins.begin(); it != plugins.end(); ++it) {
+            open(*it);
+        }
+
+        return;
+    }
+
+    const manifest_map_t manifests = read_manifests(cache);
+
+    manifest_map_t updated;
+
+    std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
+    for(auto it = plugins.begin(); it != plugins.end(); ++it) {
+        const stamp_t current = stamp(*it);
+
+        auto cached = manifests.find(*it);
+
+        // NOTE: Plugins which provide no components are opened anyway, as they are presumably
+        // loaded for their initialization side effects.
+        if(cached != manifests.end() && std::get<0>(cached->second) == std::get<0>(current)
+                                     && std::get<1>(cached->second) == std::get<1>(current)
+                                     && std::get<2>(cached->second) == std::get<2>(current)
+                                     && !std::get<3>(cached->second).empty())
+        {
+            const auto& components = std::get<3>(cached->second);
+
+            for(auto component = components.begin(); component != components.end(); ++component) {
+                m_deferred[factory_key_t(std::get<0>(*component), std::get<1>(*component))] = *it;
+            }
+
+            updated[*it] = cached->second;
+
+            continue;
+        }
+
+        std::vector<factory_key_t> recorded;
+
+        m_recording = &recorded;
+
+        try {
+            open(*it);
+        } catch(...) {
+            m_recording = nullptr;
+            throw;
+        }
+
+        m_recording = nullptr;
+
+        manifest_t manifest(
+            std::get<0>(current),
+            std::get<1>(current),
+            std::get<2>(current),
+            std::vector<std::tuple<std::string, std::string>>()
+        );
+
+        for(auto component = recorded.begin(); component != recorded.end(); ++component) {
+            std::get<3>(manifest).push_back(std::make_tuple(component->first, component->second));
+        }
+
+        updated[*it] = manifest;
+    }
+
+    if(updated != manifests) {
+        write_manifests(cache, updated);
+    }
+}
+
+std::shared_ptr<factory_concept_t>
+repository_t::demand(const std::string& id, const std::string& type) {
+    auto it = m_deferred.find(factory_key_t(id, type));
+
+    if(it == m_deferred.end()) {
+        return std::shared_ptr<factory_concept_t>();
+    }
+
+    const std::string target = it->second;
+
+    // All the plugin's components get registered once it's opened, so none of them is deferred
+    // anymore, whether the plugin is opened successfully or not.
+    for(it = m_deferred.begin(); it != m_deferred.end();) {
+        if(it->second == target) {
+            m_deferred.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    open(target);
+
+    const factory_map_t& factories = m_categories[id];
+
+    factory_map_t::const_iterator factory = factories.find(type);
+
+    if(factory == factories.end()) {
+        // The plugin has been replaced since its manifest has been cached.
+        return std::shared_ptr<factory_concept_t>();
+    }
+
+    return factory->second;
 }
 
 // Plugin preconditions validation function type.
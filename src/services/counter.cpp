@@ -64,6 +64,13 @@ struct cas {
     typedef bool result_type;
 };
 
+// Read-only command, which is served by the leader without writing it to the log.
+struct get {
+    typedef counter_machine_tag tag;
+
+    typedef int result_type;
+};
+
 }; // struct counter_machine
 
 } // namespace
@@ -79,7 +86,8 @@ struct protocol<counter_machine_tag> {
     typedef boost::mpl::list<
         counter_machine::inc,
         counter_machine::dec,
-        counter_machine::cas
+        counter_machine::cas,
+        counter_machine::get
     > messages;
 
     typedef counter_machine type;
@@ -157,6 +165,11 @@ struct counter_t::counter_machine_t {
         return res;
     }
 
+    int
+    operator()(const io::aux::frozen<counter_machine::get>&) {
+        return m_value;
+    }
+
 private:
     std::unique_ptr<logging::log_t> m_log;
     std::atomic<int> m_value;
@@ -172,6 +185,7 @@ counter_t::counter_t(context_t& context, io::reactor_t& reactor, const std::stri
     on<io::counter::inc>(std::bind(&counter_t::on_inc, this, _1));
     on<io::counter::dec>(std::bind(&counter_t::on_dec, this, _1));
     on<io::counter::cas>(std::bind(&counter_t::on_cas, this, _1, _2));
+    on<io::counter::get>(std::bind(&counter_t::on_get, this));
 
     m_raft = context.raft().insert(name, counter_machine_t(context));
 }
@@ -234,3 +248,14 @@ counter_t::on_cas(int expected, int desired) {
 
     return promise;
 }
+
+deferred<raft::command_result<int>>
+counter_t::on_get() {
+    deferred<raft::command_result<int>> promise;
+
+    m_raft->read<counter_machine::get>(
+        std::bind(deferred_producer<int>, m_raft, promise, std::placeholders::_1)
+    );
+
+    return promise;
+}
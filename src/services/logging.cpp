@@ -26,14 +26,81 @@
 
 #include "cocaine/traits/attributes.hpp"
 #include "cocaine/traits/enum.hpp"
+#include "cocaine/traits/tuple.hpp"
+#include "cocaine/traits/vector.hpp"
+
+#include <algorithm>
 
 using namespace cocaine::io;
 using namespace cocaine::logging;
 using namespace cocaine::service;
 
+namespace {
+
+// How often the idle rate limit buckets are evicted.
+const std::chrono::seconds sweep_interval(60);
+
+struct closed_upstream {
+    template<class T>
+    bool
+    operator()(const cocaine::upstream<T>& ptr) const {
+        return ptr.closed();
+    }
+};
+
+} // namespace
+
+struct logging_t::subscription_t:
+    public basic_slot<io::log::subscribe>
+{
+    typedef basic_slot<io::log::subscribe>::dispatch_type dispatch_type;
+    typedef basic_slot<io::log::subscribe>::tuple_type tuple_type;
+    typedef basic_slot<io::log::subscribe>::upstream_type upstream_type;
+
+    typedef upstream_type::protocol protocol;
+
+    subscription_t(log_context_t& backend):
+        backend(backend)
+    { }
+
+    virtual
+    std::shared_ptr<dispatch_type>
+    operator()(tuple_type&& /* args */, upstream_type&& upstream) {
+        auto locked = upstreams.synchronize();
+
+        upstream.send<protocol::chunk>(backend.verbosity());
+
+        // Save this upstream for the future notifications.
+        locked->emplace_back(std::move(upstream));
+
+        // Return an empty protocol dispatch.
+        return std::shared_ptr<dispatch_type>();
+    }
+
+    void
+    announce(priorities value) {
+        auto locked = upstreams.synchronize();
+
+        // Forget the clients which have gone away, they are never choked otherwise.
+        locked->erase(std::remove_if(locked->begin(), locked->end(), closed_upstream()), locked->end());
+
+        for(auto it = locked->begin(); it != locked->end(); ++it) {
+            it->send<protocol::chunk>(value);
+        }
+    }
+
+private:
+    log_context_t& backend;
+
+    synchronized<std::vector<upstream_type>> upstreams;
+};
+
 logging_t::logging_t(context_t& context, reactor_t& reactor, const std::string& name, const dynamic_t& args):
     api::service_t(context, reactor, name, args),
-    dispatch<io::log_tag>(name)
+    dispatch<io::log_tag>(name),
+    m_rate_limit(args.as_object().at("rate-limit", 0.0).to<double>()),
+    m_rate_burst(args.as_object().at("rate-burst", m_rate_limit).to<double>()),
+    m_swept(clock_type::now())
 {
     auto backend = args.as_object().at("backend", "core").as_string();
 
@@ -45,21 +112,219 @@ logging_t::logging_t(context_t& context, reactor_t& reactor, const std::string&
             auto log_context = log_context_t(std::move(sync_logger));
             m_logger = std::make_unique<log_context_t>(std::move(log_context));
             m_logger->set_verbosity(context.logger().verbosity());
+
+            auto config = context.config.logging.loggers.find(backend);
+
+            if(config != context.config.logging.loggers.end() && config->second.async) {
+                m_logger->set_async(*config->second.async);
+            }
         } catch (const std::out_of_range&) {
             throw cocaine::error_t("the '%s' logger is not configured", backend);
         }
     }
 
-    log_context_t* log_ptr = m_logger ? m_logger.get() : &context.logger();
+    m_backend = m_logger ? m_logger.get() : &context.logger();
+    m_subscription = std::make_shared<subscription_t>(*m_backend);
 
     using namespace std::placeholders;
 
-    on<io::log::emit>(std::bind(&log_context_t::emit, log_ptr, _1, _2, _3, _4));
-    on<io::log::set_verbosity>(std::bind(&log_context_t::set_verbosity, log_ptr, _1));
-    on<io::log::verbosity>(std::bind(&log_context_t::verbosity, log_ptr));
+    on<io::log::emit>(std::bind(&logging_t::emit, this, _1, _2, _3, _4));
+    on<io::log::emit_batch>(std::bind(&logging_t::emit_batch, this, _1));
+    on<io::log::set_verbosity>(std::bind(&logging_t::set_verbosity, this, _1));
+    on<io::log::verbosity>(std::bind(&log_context_t::verbosity, m_backend));
+    on<io::log::subscribe>(m_subscription);
 }
 
 auto
 logging_t::prototype() -> basic_dispatch_t& {
     return *this;
 }
+
+void
+logging_t::emit(priorities level, const std::string& source, const std::string& message,
+                const blackhole::log::attributes_t& attributes)
+{
+    // Messages above the verbosity don't count against the rate limit.
+    if(level > m_backend->verbosity() || !admit(source)) {
+        return;
+    }
+
+    m_backend->emit(level, source, message, attributes);
+}
+
+void
+logging_t::emit_batch(const std::vector<record_type>& batch) {
+    const priorities verbosity = m_backend->verbosity();
+
+    // Messages above the verbosity don't count against the rate limit.
+    std::vector<const std::string*> sources;
+
+    for(auto it = batch.begin(); it != batch.end(); ++it) {
+        if(std::get<0>(*it) <= verbosity) {
+            sources.push_back(&std::get<1>(*it));
+        }
+    }
+
+    const std::vector<bool> admitted = admit(sources);
+
+    std::vector<blackhole::log::record_t> records;
+
+    auto flag = admitted.begin();
+
+    for(auto it = batch.begin(); it != batch.end(); ++it) {
+        if(std::get<0>(*it) > verbosity || !*flag++) {
+            continue;
+        }
+
+        auto record = m_backend->open_record(std::get<0>(*it), std::get<1>(*it), std::get<2>(*it), std::get<3>(*it));
+
+        if(record.valid()) {
+            records.emplace_back(std::move(record));
+        }
+    }
+
+    m_backend->push(std::move(records));
+}
+
+void
+logging_t::set_verbosity(priorities value) {
+    m_backend->set_verbosity(value);
+    m_subscription->announce(value);
+}
+
+bool
+logging_t::admit(const std::string& source) {
+    if(m_rate_limit <= 0) {
+        return true;
+    }
+
+    const auto now = clock_type::now();
+
+    bool admitted = false;
+
+    std::vector<std::pair<std::string, uint64_t>> dropped;
+
+    {
+        auto buckets = m_buckets.synchronize();
+
+        if(now - m_swept >= sweep_interval) {
+            dropped = sweep(*buckets, now);
+        }
+
+        admitted = consume(*buckets, source, now, dropped);
+    }
+
+    for(auto it = dropped.begin(); it != dropped.end(); ++it) {
+        report(it->first, it->second);
+    }
+
+    return admitted;
+}
+
+std::vector<bool>
+logging_t::admit(const std::vector<const std::string*>& sources) {
+    if(m_rate_limit <= 0) {
+        return std::vector<bool>(sources.size(), true);
+    }
+
+    const auto now = clock_type::now();
+
+    std::vector<bool> admitted;
+
+    admitted.reserve(sources.size());
+
+    // Sources with messages dropped since the last report, including the evicted buckets, which
+    // are reported once the lock is released.
+    std::vector<std::pair<std::string, uint64_t>> dropped;
+
+    {
+        auto buckets = m_buckets.synchronize();
+
+        if(now - m_swept >= sweep_interval) {
+            dropped = sweep(*buckets, now);
+        }
+
+        for(auto it = sources.begin(); it != sources.end(); ++it) {
+            admitted.push_back(consume(*buckets, **it, now, dropped));
+        }
+    }
+
+    for(auto it = dropped.begin(); it != dropped.end(); ++it) {
+        report(it->first, it->second);
+    }
+
+    return admitted;
+}
+
+bool
+logging_t::consume(std::map<std::string, bucket_t>& buckets, const std::string& source,
+                   clock_type::time_point now, std::vector<std::pair<std::string, uint64_t>>& dropped)
+{
+    auto it = buckets.find(source);
+
+    if(it == buckets.end()) {
+        bucket_t bucket = { std::max(m_rate_burst, 1.0), now, 0 };
+        it = buckets.insert(std::make_pair(source, bucket)).first;
+    }
+
+    bucket_t& bucket = it->second;
+
+    const double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(
+        now - bucket.updated
+    ).count();
+
+    bucket.tokens = std::min(bucket.tokens + elapsed * m_rate_limit, std::max(m_rate_burst, 1.0));
+    bucket.updated = now;
+
+    if(bucket.tokens < 1.0) {
+        ++bucket.dropped;
+        return false;
+    }
+
+    bucket.tokens -= 1.0;
+
+    if(bucket.dropped) {
+        dropped.push_back(std::make_pair(source, bucket.dropped));
+        bucket.dropped = 0;
+    }
+
+    return true;
+}
+
+void
+logging_t::report(const std::string& source, uint64_t dropped) {
+    m_backend->emit(logging::warning, "logging", cocaine::format(
+        "dropped %d messages from '%s' due to the rate limit", dropped, source
+    ), blackhole::log::attributes_t());
+}
+
+std::vector<std::pair<std::string, uint64_t>>
+logging_t::sweep(std::map<std::string, bucket_t>& buckets, clock_type::time_point now) {
+    const double capacity = std::max(m_rate_burst, 1.0);
+
+    std::vector<std::pair<std::string, uint64_t>> evicted;
+
+    for(auto it = buckets.begin(); it != buckets.end();) {
+        const bucket_t& bucket = it->second;
+
+        const double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(
+            now - bucket.updated
+        ).count();
+
+        // A full bucket is no different from a new one, so nothing is lost but the drop counter.
+        if(bucket.tokens + elapsed * m_rate_limit < capacity) {
+            ++it;
+            continue;
+        }
+
+        if(bucket.dropped) {
+            evicted.push_back(std::make_pair(it->first, bucket.dropped));
+        }
+
+        buckets.erase(it++);
+    }
+
+    m_swept = now;
+
+    return evicted;
+}
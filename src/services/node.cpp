@@ -21,11 +21,18 @@
 #include "cocaine/detail/services/node.hpp"
 #include "cocaine/detail/services/node/app.hpp"
 
+#include "cocaine/asio/reactor.hpp"
+
 #include "cocaine/context.hpp"
+#include "cocaine/detail/chamber.hpp"
 #include "cocaine/logging.hpp"
+#include "cocaine/memory.hpp"
 
 #include "cocaine/traits/dynamic.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <mutex>
 #include <tuple>
 
 using namespace cocaine;
@@ -38,11 +45,31 @@ typedef std::map<std::string, std::string> runlist_t;
 
 } // namespace
 
+// Progress of a single runlist startup, shared by the startup workers.
+struct node_t::startup_t {
+    startup_t(const runlist_t& runlist):
+        pending(runlist.begin(), runlist.end()),
+        remaining(runlist.size())
+    { }
+
+    std::mutex mutex;
+
+    // Apps which are not picked up by the workers yet.
+    std::deque<std::pair<std::string, std::string>> pending;
+
+    // Per-app outcomes, the promise is fulfilled when there are no apps remaining.
+    dynamic_t::object_t result;
+    size_t remaining;
+
+    deferred<dynamic_t> promise;
+};
+
 node_t::node_t(context_t& context, reactor_t& reactor, const std::string& name, const dynamic_t& args):
     api::service_t(context, reactor, name, args),
     dispatch<io::node_tag>(name),
     m_context(context),
-    m_log(new logging::log_t(context, name))
+    m_log(new logging::log_t(context, name)),
+    m_cancelled(false)
 {
     using namespace std::placeholders;
 
@@ -50,6 +77,16 @@ node_t::node_t(context_t& context, reactor_t& reactor, const std::string& name,
     on<io::node::pause_app>(std::bind(&node_t::on_pause_app, this, _1));
     on<io::node::list>(std::bind(&node_t::on_list, this));
 
+    const auto concurrency = std::max<size_t>(1, args.as_object().at("startup-concurrency", 4U).to<size_t>());
+
+    // NOTE: Chambers keep references to the reactor pointers, so the vector must never reallocate.
+    m_workers.reserve(concurrency);
+
+    for(size_t i = 0; i < concurrency; ++i) {
+        m_workers.push_back(std::make_shared<reactor_t>());
+        m_chambers.push_back(std::make_unique<io::chamber_t>(name + "/startup", m_workers.back()));
+    }
+
     const auto runlist_id = args.as_object().at("runlist", "default").as_string();
 
     // It's here to keep the reference alive.
@@ -75,6 +112,12 @@ node_t::node_t(context_t& context, reactor_t& reactor, const std::string& name,
 }
 
 node_t::~node_t() {
+    m_cancelled = true;
+
+    // Wait for the startup workers to finish the apps they are starting right now, the queued ones
+    // are skipped.
+    m_chambers.clear();
+
     auto& unlocked = m_apps.value();
 
     if(unlocked.empty()) {
@@ -95,45 +138,24 @@ node_t::prototype() -> basic_dispatch_t& {
     return *this;
 }
 
-dynamic_t
+deferred<dynamic_t>
 node_t::on_start_app(const runlist_t& runlist) {
-    dynamic_t::object_t result;
+    auto startup = std::make_shared<startup_t>(runlist);
 
-    for(auto it = runlist.begin(); it != runlist.end(); ++it) {
-        if(m_apps->count(it->first)) {
-            result[it->first] = "the app is already running";
-            continue;
-        }
-
-        COCAINE_LOG_INFO(m_log, "starting the '%s' app", it->first);
+    if(runlist.empty()) {
+        startup->promise.write(dynamic_t(startup->result));
+        return startup->promise;
+    }
 
-        auto locked = m_apps.synchronize();
-        auto app    = locked->end();
-
-        try {
-            std::tie(app, std::ignore) = locked->insert({
-                it->first,
-                std::make_shared<app_t>(m_context, it->first, it->second)
-            });
-        } catch(const cocaine::error_t& e) {
-            COCAINE_LOG_ERROR(m_log, "unable to initialize the '%s' app - %s", it->first, e.what());
-            result[it->first] = std::string(e.what());
-            continue;
-        }
+    // Every worker picks up the apps one by one, so that a slowly starting app doesn't hold back
+    // the apps queued after it.
+    const size_t workers = std::min(m_workers.size(), runlist.size());
 
-        try {
-            app->second->start();
-        } catch(const cocaine::error_t& e) {
-            COCAINE_LOG_ERROR(m_log, "unable to start the '%s' app - %s", it->first, e.what());
-            locked->erase(app);
-            result[it->first] = std::string(e.what());
-            continue;
-        }
-
-        result[it->first] = "the app has been started";
+    for(size_t i = 0; i < workers; ++i) {
+        m_workers[i]->post(std::bind(&node_t::drain, this, startup));
     }
 
-    return result;
+    return startup->promise;
 }
 
 dynamic_t
@@ -172,3 +194,94 @@ node_t::on_list() const {
 
     return result;
 }
+
+void
+node_t::drain(const std::shared_ptr<startup_t>& startup) {
+    while(true) {
+        std::pair<std::string, std::string> app;
+
+        {
+            std::lock_guard<std::mutex> guard(startup->mutex);
+
+            if(startup->pending.empty()) {
+                return;
+            }
+
+            app = startup->pending.front();
+            startup->pending.pop_front();
+        }
+
+        // The apps which are not started yet are skipped on shutdown, but still reported, so that
+        // the promise is always fulfilled.
+        const std::string outcome = m_cancelled ? "the node is shutting down" : start(app.first, app.second);
+
+        std::unique_lock<std::mutex> lock(startup->mutex);
+
+        startup->result[app.first] = outcome;
+
+        if(--startup->remaining == 0) {
+            // Nobody touches the result after the last app is done.
+            lock.unlock();
+            startup->promise.write(dynamic_t(startup->result));
+        }
+    }
+}
+
+// Releases the reserved app name however the startup ends.
+struct node_t::reservation_t {
+    reservation_t(node_t& node, const std::string& name):
+        node(node),
+        name(name)
+    { }
+
+   ~reservation_t() {
+        auto locked = node.m_apps.synchronize();
+        node.m_starting.erase(name);
+    }
+
+    node_t& node;
+    const std::string name;
+};
+
+std::string
+node_t::start(const std::string& name, const std::string& profile) {
+    {
+        auto locked = m_apps.synchronize();
+
+        if(locked->count(name) || !m_starting.insert(name).second) {
+            return "the app is already running";
+        }
+    }
+
+    reservation_t reservation(*this, name);
+
+    COCAINE_LOG_INFO(m_log, "starting the '%s' app", name);
+
+    std::shared_ptr<app_t> app;
+
+    // NOTE: Apps are started on the startup workers, so nothing may escape from here, be it a
+    // filesystem error while spooling or a malformed manifest.
+    try {
+        app = std::make_shared<app_t>(m_context, name, profile);
+    } catch(const std::exception& e) {
+        COCAINE_LOG_ERROR(m_log, "unable to initialize the '%s' app - %s", name, e.what());
+        return e.what();
+    } catch(...) {
+        COCAINE_LOG_ERROR(m_log, "unable to initialize the '%s' app - unknown error", name);
+        return "unknown error";
+    }
+
+    try {
+        app->start();
+    } catch(const std::exception& e) {
+        COCAINE_LOG_ERROR(m_log, "unable to start the '%s' app - %s", name, e.what());
+        return e.what();
+    } catch(...) {
+        COCAINE_LOG_ERROR(m_log, "unable to start the '%s' app - unknown error", name);
+        return "unknown error";
+    }
+
+    m_apps->insert(std::make_pair(name, app));
+
+    return "the app has been started";
+}
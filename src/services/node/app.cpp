@@ -323,10 +323,11 @@ app_t::start() {
 
     COCAINE_LOG_DEBUG(m_log, "starting the invocation service");
 
-    // Publish the app service.
+    // Publish the app service. It only accepts connections on its reactor, so it might be shared
+    // with other apps.
     m_context.insert(m_manifest->name, std::make_unique<actor_t>(
         m_context,
-        std::make_shared<reactor_t>(),
+        m_context.reactor(m_manifest->name),
         std::unique_ptr<basic_dispatch_t>(new app_service_t(m_manifest->name, *this))
     ));
 
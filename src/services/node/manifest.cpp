@@ -20,27 +20,31 @@
 
 #include "cocaine/detail/services/node/manifest.hpp"
 
-#include "cocaine/traits/dynamic.hpp"
+#include "cocaine/traits/map.hpp"
 
 #include <unistd.h>
 
+using namespace cocaine;
 using namespace cocaine::engine;
 
-manifest_t::manifest_t(context_t& context, const std::string& name_):
-    cached<dynamic_t>(context, "manifests", name_),
-    name(name_)
-{
-    endpoint = cocaine::format("%s/%s.%d", context.config.path.runtime, name, ::getpid());
-
-    environment = as_object().at("environment", dynamic_t::object_t()).to<std::map<std::string, std::string>>();
+manifest_t::manifest_t(context_t& context, const std::string& name_) {
+    cached<manifest_t> manifest(context, "manifests", name_);
 
-    if(as_object().find("slave") != as_object().end()) {
-        executable = as_object().at("slave").as_string();
-    } else {
-        throw cocaine::error_t("app runnable object has not been specified");
-    }
+    *this = manifest.object();
 
-    // TODO: Ability to choose app bindpoint.
-    local = as_object().at("local", false).as_bool();
+    // These are not a part of the stored object.
+    name     = name_;
+    endpoint = cocaine::format("%s/%s.%d", context.config.path.runtime, name, ::getpid());
+    m_source = manifest.source();
 }
 
+const schema_t<manifest_t>&
+schema_traits<manifest_t>::schema() {
+    static const schema_t<manifest_t> instance = schema_t<manifest_t>()
+        .optional("environment", &manifest_t::environment, std::map<std::string, std::string>())
+        .required("slave", &manifest_t::executable)
+        // TODO: Ability to choose app bindpoint.
+        .optional("local", &manifest_t::local, false);
+
+    return instance;
+}
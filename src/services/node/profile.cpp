@@ -20,61 +20,89 @@
 
 #include "cocaine/detail/services/node/profile.hpp"
 
-#include "cocaine/traits/dynamic.hpp"
+#include <algorithm>
 
+using namespace cocaine;
 using namespace cocaine::engine;
 
-profile_t::profile_t(context_t& context, const std::string& name_):
-    cached<dynamic_t>(context, "profiles", name_),
-    name(name_)
-{
-    log_output          = as_object().at("log-output", defaults::log_output).as_bool();
-    heartbeat_timeout   = as_object().at("heartbeat-timeout", defaults::heartbeat_timeout).to<double>();
-    idle_timeout        = as_object().at("idle-timeout", defaults::idle_timeout).to<double>();
-    startup_timeout     = as_object().at("startup-timeout", defaults::startup_timeout).to<double>();
-    termination_timeout = as_object().at("termination-timeout", defaults::termination_timeout).to<double>();
-    concurrency         = as_object().at("concurrency", defaults::concurrency).to<uint64_t>();
-    crashlog_limit      = as_object().at("crashlog-limit", defaults::crashlog_limit).to<uint64_t>();
-    pool_limit          = as_object().at("pool-limit", defaults::pool_limit).to<uint64_t>();
-    queue_limit         = as_object().at("queue-limit", defaults::queue_limit).to<uint64_t>();
+profile_t::profile_t(context_t& context, const std::string& name_) {
+    *this = cached<profile_t>(context, "profiles", name_).object();
 
-    unsigned long default_threshold = std::max(1UL, queue_limit / pool_limit / 2);
-
-    grow_threshold      = as_object().at("grow-threshold", default_threshold).to<uint64_t>();
+    // The profile name is not a part of the stored object.
+    name = name_;
+}
 
-    // Isolation
+namespace {
 
-    const auto& isolate_config = as_object().at("isolate", dynamic_t::empty_object).as_object();
+unsigned long
+default_threshold(const profile_t& profile) {
+    if(profile.pool_limit == 0) {
+        // Will be rejected by the validator anyway.
+        return 1UL;
+    }
 
-    isolate = {
-        isolate_config.at("type", "process").as_string(),
-        isolate_config.at("args", dynamic_t::empty_object)
-    };
+    return std::max(1UL, profile.queue_limit / profile.pool_limit / 2);
+}
 
-    // Validation
+profile_t::isolate_t
+default_isolate() {
+    profile_t::isolate_t isolate = { "process", dynamic_t::empty_object };
+    return isolate;
+}
 
-    if(heartbeat_timeout <= 0.0f) {
+void
+validate(const profile_t& profile) {
+    if(profile.heartbeat_timeout <= 0.0f) {
         throw cocaine::error_t("slave heartbeat timeout must be positive");
     }
 
-    if(idle_timeout < 0.0f) {
+    if(profile.idle_timeout < 0.0f) {
         throw cocaine::error_t("slave idle timeout must non-negative");
     }
 
-    if(startup_timeout <= 0.0f) {
+    if(profile.startup_timeout <= 0.0f) {
         throw cocaine::error_t("slave startup timeout must be positive");
     }
 
-    if(termination_timeout <= 0.0f) {
+    if(profile.termination_timeout <= 0.0f) {
         throw cocaine::error_t("engine termination timeout must be non-negative");
     }
 
-    if(pool_limit == 0) {
+    if(profile.pool_limit == 0) {
         throw cocaine::error_t("engine pool limit must be positive");
     }
 
-    if(concurrency == 0) {
+    if(profile.concurrency == 0) {
         throw cocaine::error_t("engine concurrency must be positive");
     }
 }
 
+} // namespace
+
+const schema_t<profile_t>&
+schema_traits<profile_t>::schema() {
+    static const schema_t<profile_t> instance = schema_t<profile_t>()
+        .optional("log-output", &profile_t::log_output, defaults::log_output)
+        .optional("heartbeat-timeout", &profile_t::heartbeat_timeout, defaults::heartbeat_timeout)
+        .optional("idle-timeout", &profile_t::idle_timeout, defaults::idle_timeout)
+        .optional("startup-timeout", &profile_t::startup_timeout, defaults::startup_timeout)
+        .optional("termination-timeout", &profile_t::termination_timeout, defaults::termination_timeout)
+        .optional("concurrency", &profile_t::concurrency, defaults::concurrency)
+        .optional("crashlog-limit", &profile_t::crashlog_limit, defaults::crashlog_limit)
+        .optional("pool-limit", &profile_t::pool_limit, defaults::pool_limit)
+        .optional("queue-limit", &profile_t::queue_limit, defaults::queue_limit)
+        .derived("grow-threshold", &profile_t::grow_threshold, &default_threshold)
+        .optional("isolate", &profile_t::isolate, default_isolate())
+        .validate(&validate);
+
+    return instance;
+}
+
+const schema_t<profile_t::isolate_t>&
+schema_traits<profile_t::isolate_t>::schema() {
+    static const schema_t<profile_t::isolate_t> instance = schema_t<profile_t::isolate_t>()
+        .optional("type", &profile_t::isolate_t::type, "process")
+        .optional("args", &profile_t::isolate_t::args, dynamic_t::empty_object);
+
+    return instance;
+}
@@ -131,7 +131,13 @@ slave_t::slave_t(context_t& context, reactor_t& reactor, const manifest_t& manif
     args["--locator"] = cocaine::format("%s:%d", m_context.config.network.hostname, m_context.config.network.locator);
     args["--uuid"] = m_id;
 
-    m_handle = isolate->spawn(m_manifest.executable, args, m_manifest.environment);
+    auto environment = m_manifest.environment;
+
+    // NOTE: Let the slave know the runtime verbosity right away, so that it could drop the records
+    // which would be filtered out anyway before sending them to the logging service.
+    environment["COCAINE_LOG_VERBOSITY"] = cocaine::format("%d", static_cast<int>(m_context.logger().verbosity()));
+
+    m_handle = isolate->spawn(m_manifest.executable, args, environment);
 
     // Start reading the standard outputs of the slave.
     m_output_pipe.reset(new readable_stream<pipe_t>(reactor, m_handle->stdout()));
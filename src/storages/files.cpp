@@ -23,16 +23,73 @@
 #include "cocaine/context.hpp"
 #include "cocaine/logging.hpp"
 
-#include <numeric>
+#include <algorithm>
+#include <set>
 
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 using namespace cocaine::storage;
 
 namespace fs = boost::filesystem;
 
+struct files_t::collection_t {
+    collection_t():
+        indexed(false)
+    { }
+
+    // NOTE: Reads and tag lookups share the collection, writes and removals own it exclusively.
+    boost::shared_mutex mutex;
+
+    // Inverted tag index, built lazily on the first lookup in this collection and maintained by
+    // writes and removals afterwards.
+    bool indexed;
+
+    std::map<std::string, std::set<std::string>> tags;
+    std::map<std::string, std::set<std::string>> objects;
+};
+
+typedef boost::shared_lock<boost::shared_mutex> shared_lock_t;
+typedef boost::unique_lock<boost::shared_mutex> unique_lock_t;
+
+namespace {
+
+// Removes the staging file unless it has been renamed over the object, however the write fails.
+struct staging_t {
+    explicit
+    staging_t(const fs::path& path_):
+        path(path_),
+        released(false)
+    { }
+
+   ~staging_t() {
+        if(!released) {
+            boost::system::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    void
+    release() {
+        released = true;
+    }
+
+    const fs::path path;
+
+private:
+    bool released;
+};
+
+} // namespace
+
 files_t::files_t(context_t& context, const std::string& name, const dynamic_t& args):
     category_type(context, name, args),
     m_log(new logging::log_t(context, name)),
@@ -45,7 +102,15 @@ files_t::~files_t() {
 
 std::string
 files_t::read(const std::string& collection, const std::string& key) {
-    std::lock_guard<std::mutex> guard(m_mutex);
+    const auto state = peek(collection);
+
+    // NOTE: Collections which haven't been written to by this process are read without the lock,
+    // which is fine, as objects are replaced by atomic renames anyway.
+    shared_lock_t guard;
+
+    if(state) {
+        shared_lock_t(state->mutex).swap(guard);
+    }
 
     const fs::path file_path(m_storage_path / collection / key);
 
@@ -75,7 +140,9 @@ files_t::read(const std::string& collection, const std::string& key) {
 
 void
 files_t::write(const std::string& collection, const std::string& key, const std::string& blob, const std::vector<std::string>& tags) {
-    std::lock_guard<std::mutex> guard(m_mutex);
+    const auto state = lookup(collection);
+
+    unique_lock_t guard(state->mutex);
 
     const fs::path store_path(m_storage_path / collection);
     const auto store_status = fs::status(store_path);
@@ -102,12 +169,33 @@ files_t::write(const std::string& collection, const std::string& key, const std:
         file_path
     );
 
-    fs::ofstream stream(file_path, fs::ofstream::out | fs::ofstream::trunc | fs::ofstream::binary);
+    // NOTE: Objects are written aside and then renamed over the old ones, so that readers which
+    // have the old object mapped into memory never observe it being truncated under their feet.
+    staging_t staging(store_path / ("." + key + ".staging"));
+
+    fs::ofstream stream(staging.path, fs::ofstream::out | fs::ofstream::trunc | fs::ofstream::binary);
 
     if(!stream) {
         throw storage_error_t("unable to access object '%s' in '%s'", key, collection);
     }
 
+    stream.write(blob.c_str(), blob.size());
+    stream.close();
+
+    if(!stream) {
+        throw storage_error_t("unable to write object '%s' in '%s'", key, collection);
+    }
+
+    try {
+        fs::rename(staging.path, file_path);
+    } catch(const fs::filesystem_error& e) {
+        throw storage_error_t("unable to write object '%s' in '%s'", key, collection);
+    }
+
+    staging.release();
+
+    // The object is in place now, so that neither the tag symlinks nor the index entries can point
+    // to an object which failed to be written.
     for(auto it = tags.begin(); it != tags.end(); ++it) {
         const auto tag_path = store_path / *it;
         const auto tag_status = fs::status(tag_path);
@@ -122,24 +210,28 @@ files_t::write(const std::string& collection, const std::string& key, const std:
             throw storage_error_t("tag '%s' is corrupted", *it);
         }
 
-        if(fs::is_symlink(tag_path / key)) {
-            continue;
+        if(!fs::is_symlink(tag_path / key)) {
+            try {
+                fs::create_symlink(file_path, tag_path / key);
+            } catch(const fs::filesystem_error& e) {
+                throw storage_error_t("unable to assign tag '%s' to object '%s' in '%s'", *it, key, collection);
+            }
         }
 
-        try {
-            fs::create_symlink(file_path, tag_path / key);
-        } catch(const fs::filesystem_error& e) {
-            throw storage_error_t("unable to assign tag '%s' to object '%s' in '%s'", *it, key, collection);
+        if(state->indexed) {
+            state->tags[*it].insert(key);
+            state->objects[key].insert(*it);
         }
     }
 
-    stream.write(blob.c_str(), blob.size());
-    stream.close();
+    invalidate(collection, key);
 }
 
 void
 files_t::remove(const std::string& collection, const std::string& key) {
-    std::lock_guard<std::mutex> guard(m_mutex);
+    const auto state = lookup(collection);
+
+    unique_lock_t guard(state->mutex);
 
     const auto store_path(m_storage_path / collection);
     const auto file_path(store_path / key);
@@ -158,21 +250,121 @@ files_t::remove(const std::string& collection, const std::string& key) {
         } catch(const fs::filesystem_error& e) {
             throw storage_error_t("unable to remove object '%s' from '%s'", key, collection);
         }
+
+        invalidate(collection, key);
+    }
+
+    if(!state->indexed) {
+        // Dangling tag symlinks will be purged when the index is built.
+        return;
     }
+
+    auto it = state->objects.find(key);
+
+    if(it == state->objects.end()) {
+        return;
+    }
+
+    for(auto tag = it->second.begin(); tag != it->second.end(); ++tag) {
+        state->tags[*tag].erase(key);
+
+        // The tag index knows exactly which symlinks point to this object, so drop them right away.
+        try {
+            fs::remove(store_path / *tag / key);
+        } catch(const fs::filesystem_error& e) {
+            COCAINE_LOG_WARNING(m_log, "unable to purge object '%s' from tag '%s'", key, *tag);
+        }
+    }
+
+    state->objects.erase(it);
 }
 
 namespace {
 
-struct intersect {
-    template<class T>
-    T
-    operator()(const T& accumulator, T& keys) const {
-        T result;
+struct mapping_t {
+    mapping_t(void* base_, size_t size_):
+        base(base_),
+        size(size_)
+    { }
+
+   ~mapping_t() {
+        ::munmap(base, size);
+    }
 
-        std::sort(keys.begin(), keys.end());
-        std::set_intersection(accumulator.begin(), accumulator.end(), keys.begin(), keys.end(), std::back_inserter(result));
+    void* const  base;
+    const size_t size;
+};
+
+} // namespace
+
+cocaine::api::blob_t
+files_t::view(const std::string& collection, const std::string& key) {
+    const auto state = peek(collection);
+
+    shared_lock_t guard;
 
-        return result;
+    if(state) {
+        shared_lock_t(state->mutex).swap(guard);
+    }
+
+    const fs::path file_path(m_storage_path / collection / key);
+
+    const int fd = ::open(file_path.string().c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(fd == -1) {
+        if(errno == ENOENT) {
+            throw storage_error_t("object '%s' has not been found in '%s'", key, collection);
+        } else {
+            throw storage_error_t("unable to access object '%s' in '%s'", key, collection);
+        }
+    }
+
+    struct stat info;
+
+    if(::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw storage_error_t("unable to access object '%s' in '%s'", key, collection);
+    }
+
+    if(info.st_size == 0) {
+        ::close(fd);
+        return api::blob_t(std::string());
+    }
+
+    COCAINE_LOG_DEBUG(
+        m_log,
+        "mapping object '%s', collection: %s, path: %s",
+        key,
+        collection,
+        file_path
+    );
+
+    void* base = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // NOTE: The mapping keeps the file contents alive on its own, even after the object is replaced.
+    ::close(fd);
+
+    if(base == MAP_FAILED) {
+        throw storage_error_t("unable to map object '%s' in '%s'", key, collection);
+    }
+
+    // Objects viewed this way are mostly consumed front to back, like app archives are.
+    ::madvise(base, info.st_size, MADV_SEQUENTIAL);
+
+    return api::blob_t(
+        static_cast<const char*>(base),
+        info.st_size,
+        std::make_shared<mapping_t>(base, info.st_size)
+    );
+}
+
+namespace {
+
+struct by_size {
+    template<class T>
+    bool
+    operator()(const T* lhs, const T* rhs) const {
+        return lhs->size() < rhs->size();
     }
 };
 
@@ -180,57 +372,162 @@ struct intersect {
 
 std::vector<std::string>
 files_t::find(const std::string& collection, const std::vector<std::string>& tags) {
-    std::lock_guard<std::mutex> guard(m_mutex);
-
-    const fs::path store_path(m_storage_path / collection);
+    if(tags.empty()) {
+        return std::vector<std::string>();
+    }
 
-    if(!fs::exists(store_path) || tags.empty()) {
+    // Don't bring the state into existence for the collections which don't exist at all.
+    if(!peek(collection) && !fs::exists(m_storage_path / collection)) {
         return std::vector<std::string>();
     }
 
-    std::vector<std::vector<std::string>> result;
+    const auto state = lookup(collection);
+
+    shared_lock_t guard(state->mutex);
+
+    if(!state->indexed) {
+        guard.unlock();
+
+        {
+            unique_lock_t exclusive(state->mutex);
+
+            // Some other thread might have built the index while this one was waiting for the lock.
+            if(!state->indexed) index(collection, *state);
+        }
+
+        guard.lock();
+    }
+
+    std::vector<const std::set<std::string>*> sets;
 
     for(auto tag = tags.begin(); tag != tags.end(); ++tag) {
-        auto tagged = result.insert(result.end(), std::vector<std::string>());
+        auto it = state->tags.find(*tag);
 
-        if(!fs::exists(store_path / *tag)) {
+        if(it == state->tags.end() || it->second.empty()) {
             // If one of the tags doesn't exist, the intersection is evidently empty.
             return std::vector<std::string>();
         }
 
-        fs::directory_iterator it(store_path / *tag), end;
+        sets.push_back(&it->second);
+    }
+
+    // NOTE: Intersect starting with the smallest set, so that the number of lookups is bounded by
+    // its size times the number of tags. The result is sorted, as the sets are.
+    std::sort(sets.begin(), sets.end(), by_size());
+
+    std::vector<std::string> result;
+
+    for(auto key = sets.front()->begin(); key != sets.front()->end(); ++key) {
+        bool matches = true;
+
+        for(auto it = sets.begin() + 1; matches && it != sets.end(); ++it) {
+            matches = (*it)->count(*key) != 0;
+        }
+
+        if(matches) {
+            result.push_back(*key);
+        }
+    }
+
+    return result;
+}
+
+auto
+files_t::lookup(const std::string& collection) -> std::shared_ptr<collection_t> {
+    auto ptr = m_collections.synchronize();
+    auto& state = (*ptr)[collection];
+
+    if(!state) {
+        state = std::make_shared<collection_t>();
+    }
+
+    return state;
+}
+
+auto
+files_t::peek(const std::string& collection) const -> std::shared_ptr<collection_t> {
+    auto ptr = m_collections.synchronize();
+    auto it = ptr->find(collection);
+
+    if(it == ptr->end()) {
+        return std::shared_ptr<collection_t>();
+    }
+
+    return it->second;
+}
+
+void
+files_t::index(const std::string& collection, collection_t& state) {
+    const fs::path store_path(m_storage_path / collection);
+
+    state.tags.clear();
+    state.objects.clear();
+
+    if(fs::exists(store_path)) {
+        COCAINE_LOG_DEBUG(m_log, "building tag index, collection: %s, path: %s", collection, store_path);
+
+        fs::directory_iterator tag(store_path), end;
+
+        for(; tag != end; ++tag) {
+            if(!fs::is_directory(tag->status())) {
+                continue;
+            }
 
-        while(it != end) {
 #if BOOST_VERSION >= 104600
-            const std::string object = it->path().filename().string();
+            const std::string name = tag->path().filename().string();
 #else
-            const std::string object = it->path().filename();
+            const std::string name = tag->path().filename();
 #endif
 
-            if(!fs::exists(*it)) {
-                COCAINE_LOG_DEBUG(m_log, "purging object '%s' from tag '%s'", object, *tag);
+            // NOTE: Tags are created on demand, so an empty tag entry is fine here.
+            auto& keys = state.tags[name];
 
-                // Remove the symlink if the object was removed.
-                fs::remove(*it++);
+            fs::directory_iterator it(tag->path());
 
-                continue;
-            }
+            while(it != end) {
+#if BOOST_VERSION >= 104600
+                const std::string object = it->path().filename().string();
+#else
+                const std::string object = it->path().filename();
+#endif
+
+                if(!fs::exists(*it)) {
+                    COCAINE_LOG_DEBUG(m_log, "purging object '%s' from tag '%s'", object, name);
+
+                    // Remove the symlink if the object was removed.
+                    fs::remove(*it++);
 
-            tagged->push_back(object);
+                    continue;
+                }
 
-            ++it;
+                keys.insert(object);
+                state.objects[object].insert(name);
+
+                ++it;
+            }
         }
     }
 
-    std::vector<std::string> initial = std::move(result.back());
+    state.indexed = true;
+}
+
+boost::optional<std::string>
+files_t::version(const std::string& collection, const std::string& key) {
+    const fs::path file_path(m_storage_path / collection / key);
 
-    // NOTE: Pop the initial accumulator value from the result queue, so that it
-    // won't be intersected with itself later.
-    result.pop_back();
+    struct stat info;
 
-    // NOTE: Sort the initial accumulator value here once, because it will always
-    // be kept sorted inside the functor by std::set_intersection().
-    std::sort(initial.begin(), initial.end());
+    if(::stat(file_path.string().c_str(), &info) != 0) {
+        return boost::none;
+    }
+
+#ifdef __APPLE__
+    const long nanoseconds = info.st_mtimespec.tv_nsec;
+#else
+    const long nanoseconds = info.st_mtim.tv_nsec;
+#endif
 
-    return std::accumulate(result.begin(), result.end(), initial, intersect());
+    // NOTE: Modification time alone is not enough, as the file might be replaced with another one
+    // within the timestamp granularity, so the inode number and the size are mixed in as well.
+    return cocaine::format("%d:%d.%09d:%d", info.st_ino, info.st_mtime, nanoseconds, info.st_size);
 }
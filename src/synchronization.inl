@@ -21,8 +21,11 @@
 #include "cocaine/traits/graph.hpp"
 #include "cocaine/traits/tuple.hpp"
 
+#include <set>
+
 struct context_t::synchronization_t:
-    public basic_slot<io::locator::synchronize>
+    public basic_slot<io::locator::synchronize>,
+    public std::enable_shared_from_this<synchronization_t>
 {
     typedef result_of<io::locator::synchronize>::type result_type;
 
@@ -38,32 +41,75 @@ struct context_t::synchronization_t:
     std::shared_ptr<dispatch_type>
     operator()(tuple_type&& args, upstream_type&& upstream);
 
+    // Marks the service as published or withdrawn. Changes are announced to the remote clients in
+    // batches, at most once per the coalescing window.
+    void
+    announce(const std::string& name);
+
+    // Binds the announcements to the locator reactor.
     void
-    announce();
+    bind(const std::shared_ptr<reactor_t>& reactor);
 
     void
     shutdown();
 
 private:
-    auto
-    dump() const -> result_type;
+    // Updates the dump with the pending changes. Must be called with the mutex held.
+    void
+    apply();
+
+    void
+    schedule(const std::shared_ptr<reactor_t>& loop);
+
+    void
+    on_timer(ev::timer&, int);
+
+    void
+    stop();
 
 private:
     context_t& self;
 
+    std::mutex mutex;
+
+    // Service list as it was announced the last time, and the services changed since then.
+    result_type dump;
+    std::set<std::string> changes;
+
     // Remote clients for future updates.
     std::vector<upstream_type> upstreams;
+
+    // Locator reactor and the coalescing timer, which is only touched on the locator thread.
+    std::shared_ptr<reactor_t> reactor;
+    std::unique_ptr<ev::timer> timer;
+
+    // Whether an announcement is already scheduled.
+    bool scheduled;
 };
 
+namespace {
+
+// Changes made within this interval, in seconds, are announced together.
+const float announcement_window = 0.1f;
+
+} // namespace
+
 context_t::synchronization_t::synchronization_t(context_t& self_):
-    self(self_)
+    self(self_),
+    scheduled(false)
 { }
 
 auto
 context_t::synchronization_t::operator()(tuple_type&& /* args */, upstream_type&& upstream)
     -> std::shared_ptr<dispatch_type>
 {
-    upstream.send<protocol::chunk>(dump());
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // The new client gets the up-to-date list right away, the others will get it with the pending
+    // announcement anyway.
+    apply();
+
+    upstream.send<protocol::chunk>(dump);
 
     // Save this upstream for the future notifications.
     upstreams.emplace_back(std::move(upstream));
@@ -73,32 +119,100 @@ context_t::synchronization_t::operator()(tuple_type&& /* args */, upstream_type&
 }
 
 void
-context_t::synchronization_t::announce() {
-    result_type result = dump();
+context_t::synchronization_t::announce(const std::string& name) {
+    std::lock_guard<std::mutex> guard(mutex);
 
-    for(auto it = upstreams.begin(); it != upstreams.end(); ++it) {
-        it->send<protocol::chunk>(result);
+    changes.insert(name);
+
+    if(!reactor || scheduled) {
+        return;
     }
+
+    scheduled = true;
+
+    reactor->post(std::bind(&synchronization_t::schedule, shared_from_this(), reactor));
+}
+
+void
+context_t::synchronization_t::bind(const std::shared_ptr<reactor_t>& reactor_) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    reactor = reactor_;
 }
 
 void
 context_t::synchronization_t::shutdown() {
+    std::lock_guard<std::mutex> guard(mutex);
+
     for(auto it = upstreams.begin(); it != upstreams.end(); ++it) {
         it->send<protocol::choke>();
     }
 
     upstreams.clear();
+
+    if(reactor) {
+        // The timer has to be stopped on the locator thread.
+        reactor->post(std::bind(&synchronization_t::stop, shared_from_this()));
+        reactor.reset();
+    }
 }
 
-auto
-context_t::synchronization_t::dump() const -> result_type {
-    result_type result;
+void
+context_t::synchronization_t::apply() {
+    if(changes.empty()) {
+        return;
+    }
 
     auto locked = self.m_services.synchronize();
 
-    for(auto it = locked->begin(); it != locked->end(); ++it) {
-        result[it->first] = it->second->metadata();
+    for(auto it = changes.begin(); it != changes.end(); ++it) {
+        auto service = locked->begin();
+
+        while(service != locked->end() && service->first != *it) {
+            ++service;
+        }
+
+        if(service != locked->end()) {
+            dump[*it] = service->second->metadata();
+        } else {
+            dump.erase(*it);
+        }
     }
 
-    return result;
+    changes.clear();
+}
+
+void
+context_t::synchronization_t::schedule(const std::shared_ptr<reactor_t>& loop) {
+    if(!timer) {
+        timer = std::make_unique<ev::timer>(loop->native());
+        timer->set<synchronization_t, &synchronization_t::on_timer>(this);
+    }
+
+    timer->start(announcement_window);
+}
+
+void
+context_t::synchronization_t::on_timer(ev::timer&, int) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    scheduled = false;
+
+    if(changes.empty()) {
+        return;
+    }
+
+    apply();
+
+    for(auto it = upstreams.begin(); it != upstreams.end(); ++it) {
+        it->send<protocol::chunk>(dump);
+    }
+}
+
+void
+context_t::synchronization_t::stop() {
+    if(timer) {
+        timer->stop();
+        timer.reset();
+    }
 }
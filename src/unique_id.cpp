@@ -24,8 +24,61 @@
 
 using namespace cocaine;
 
+namespace {
+
+// Generating every ID with uuid_generate() means reading the system entropy source each time, so
+// only the per-thread seed is generated this way, and the IDs are derived from it and a counter.
+
+struct generator_state_t {
+    bool seeded;
+    uint64_t seed[2];
+    uint64_t counter;
+};
+
+__thread generator_state_t generator_state = { false, { 0, 0 }, 0 };
+
+const uint64_t mask = (1ULL << 62) - 1;
+
+// The finalizer of the SplitMix64 generator, reduced to 62 bits, so that it leaves room for the UUID
+// variant bits. Both the xorshifts and the multiplications by odd constants modulo 2^62 are
+// bijections, so distinct counter values of a thread are never mapped to the same ID, while the IDs
+// still don't look sequential. The IDs of different threads only differ by their random seeds, so
+// those can collide, but with the same odds as any random UUIDs.
+uint64_t
+mix(uint64_t value) {
+    value &= mask;
+    value = ((value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL) & mask;
+    value = ((value ^ (value >> 27)) * 0x94D049BB133111EBULL) & mask;
+
+    return value ^ (value >> 31);
+}
+
+} // namespace
+
 unique_id_t::unique_id_t() {
-    uuid_generate(reinterpret_cast<unsigned char*>(uuid.data()));
+    generator_state_t& state = generator_state;
+
+    if(!state.seeded) {
+        uuid_generate(reinterpret_cast<unsigned char*>(state.seed));
+        state.seeded = true;
+    }
+
+    uuid[0] = state.seed[0];
+
+    const uint64_t value = mix(state.seed[1] + state.counter++);
+
+    // Keep the IDs well-formed random (version 4) UUIDs, as they are passed to the slaves.
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(uuid.data());
+
+    bytes[6] = (bytes[6] & 0x0F) | 0x40;
+
+    // NOTE: The mixed value is laid out byte by byte around the variant bits, so that none of its
+    // bits are overwritten, whatever the byte order is.
+    bytes[8] = 0x80 | static_cast<unsigned char>(value >> 56);
+
+    for(size_t i = 9; i < 16; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * (15 - i)));
+    }
 }
 
 unique_id_t::unique_id_t(const std::string& other) {
@@ -41,15 +94,24 @@ unique_id_t::unique_id_t(const std::string& other) {
 
 std::string
 unique_id_t::string() const {
-    // A storage for a 36-character long UUID plus the trailing zero.
-    char unparsed[37];
+    static const char digits[] = "0123456789abcdef";
 
-    uuid_unparse_lower(
-        reinterpret_cast<const unsigned char*>(uuid.data()),
-        unparsed
-    );
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(uuid.data());
+
+    // The canonical 8-4-4-4-12 form, same as uuid_unparse_lower() produces.
+    char unparsed[36];
+    char* it = unparsed;
+
+    for(size_t i = 0; i < 16; ++i) {
+        if(i == 4 || i == 6 || i == 8 || i == 10) {
+            *it++ = '-';
+        }
+
+        *it++ = digits[bytes[i] >> 4];
+        *it++ = digits[bytes[i] & 0x0F];
+    }
 
-    return unparsed;
+    return std::string(unparsed, sizeof(unparsed));
 }
 
 bool